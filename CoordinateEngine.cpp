@@ -0,0 +1,182 @@
+#include <Arduino.h>
+
+#include "./CoordinateEngine.h"
+
+// Lets GCC vectorize the batch loops on the host (the Release build uses -O3). The AVR and ARM boards have no vector units
+#if defined(__GNUC__) && !defined(__AVR__) && !defined(__arm__)
+	#define COORDINATE_ENGINE_VECTORIZE _Pragma("GCC ivdep")
+#else
+	#define COORDINATE_ENGINE_VECTORIZE
+#endif
+
+// Arduino's radians() and degrees() multiply with a double constant, which would turn every float policy calculation into double
+template<typename Real>
+static inline Real toRadians(const Real degrees) {
+	return degrees * static_cast<Real>(DEG_TO_RAD);
+}
+
+template<typename Real>
+static inline Real toDegrees(const Real radians) {
+	return radians * static_cast<Real>(RAD_TO_DEG);
+}
+
+
+/*
+ * The matrix follows from the usual formulas with the hour angle H = LST - Ra:
+ * north = cos(lat) * sin(dec) - sin(lat) * cos(dec) * cos(H)
+ * east  = -cos(dec) * sin(H)
+ * up    = sin(lat) * sin(dec) + cos(lat) * cos(dec) * cos(H)
+ * with cos(dec) * cos(H) = cos(LST) * x + sin(LST) * y and cos(dec) * sin(H) = sin(LST) * x - cos(LST) * y
+ */
+template<typename Policy>
+void BasicCoordinateEngine<Policy>::update(const double localSiderealTime, const ObserverTrigonometry& observer) {
+	if (localSiderealTime == _localSiderealTime && observer.version == _observerVersion) {
+		return;
+	}
+
+	const Real lst = toRadians(static_cast<Real>(localSiderealTime));
+	const Real sinLst = Policy::sin(lst);
+	const Real cosLst = Policy::cos(lst);
+	const Real sinLatitude = static_cast<Real>(observer.sinLatitude);
+	const Real cosLatitude = static_cast<Real>(observer.cosLatitude);
+
+	_matrix[0][0] = -sinLatitude * cosLst;
+	_matrix[0][1] = -sinLatitude * sinLst;
+	_matrix[0][2] = cosLatitude;
+
+	_matrix[1][0] = -sinLst;
+	_matrix[1][1] = cosLst;
+	_matrix[1][2] = 0.;
+
+	_matrix[2][0] = cosLatitude * cosLst;
+	_matrix[2][1] = cosLatitude * sinLst;
+	_matrix[2][2] = sinLatitude;
+
+	_localSiderealTime = localSiderealTime;
+	_observerVersion = observer.version;
+}
+
+
+template<typename Policy>
+typename BasicCoordinateEngine<Policy>::Vector BasicCoordinateEngine<Policy>::equatorialVector(RaDecPosition position) {
+	const Real ra = toRadians(static_cast<Real>(position.rightAscension));
+	const Real dec = toRadians(static_cast<Real>(position.declination));
+	const Real cosDec = Policy::cos(dec);
+
+	return { cosDec * Policy::cos(ra), cosDec * Policy::sin(ra), Policy::sin(dec) };
+}
+
+
+template<typename Policy>
+AzAlt<typename Policy::Real> BasicCoordinateEngine<Policy>::toHorizontal(RaDecPosition position) const {
+	return toHorizontal(equatorialVector(position));
+}
+
+
+/*
+ * The altitude uses atan2() instead of asin(up). asin() loses most of its precision close to the zenith,
+ * which is more than a step of the altitude axis with the float policies
+ */
+template<typename Policy>
+AzAlt<typename Policy::Real> BasicCoordinateEngine<Policy>::toHorizontal(const Vector& v) const {
+	const Real north = _matrix[0][0] * v.x + _matrix[0][1] * v.y + _matrix[0][2] * v.z;
+	const Real east = _matrix[1][0] * v.x + _matrix[1][1] * v.y;
+	const Real up = _matrix[2][0] * v.x + _matrix[2][1] * v.y + _matrix[2][2] * v.z;
+
+	const Real alt = toDegrees(Policy::atan2(up, Policy::sqrt(north * north + east * east)));
+
+	Real az = toDegrees(Policy::atan2(east, north));
+	if (az < 0) {
+		az += 360;
+	}
+
+	return { az, alt };
+}
+
+
+/*
+ * The matrix is orthogonal, so the inverse rotation is done with its transpose
+ */
+template<typename Policy>
+RaDecPosition BasicCoordinateEngine<Policy>::toEquatorial(AzAlt<Real> position) const {
+	const Real az = toRadians(position.azimuth);
+	const Real alt = toRadians(position.altitude);
+	const Real cosAlt = Policy::cos(alt);
+
+	const Real north = cosAlt * Policy::cos(az);
+	const Real east = cosAlt * Policy::sin(az);
+	const Real up = Policy::sin(alt);
+
+	const Real x = _matrix[0][0] * north + _matrix[1][0] * east + _matrix[2][0] * up;
+	const Real y = _matrix[0][1] * north + _matrix[1][1] * east + _matrix[2][1] * up;
+	const Real z = _matrix[0][2] * north + _matrix[2][2] * up;
+
+	const Real dec = toDegrees(Policy::atan2(z, Policy::sqrt(x * x + y * y)));
+
+	Real ra = toDegrees(Policy::atan2(y, x));
+	if (ra < 0) {
+		ra += 360;
+	}
+
+	return { ra, dec };
+}
+
+
+/*
+ * Derivatives of the horizontal unit vector with respect to the sidereal time:
+ * d north = -sin(lat) * east, d east = sin(lat) * north - cos(lat) * up, d up = cos(lat) * east
+ * Inserted into the derivatives of azimuth = atan2(east, north) and altitude = atan2(up, sqrt(north^2 + east^2)):
+ * d azimuth = sin(lat) - cos(lat) * cos(az) * tan(alt)
+ * d altitude = cos(lat) * sin(az)
+ * The matrix holds sin(lat) and cos(lat) in its last column
+ */
+template<typename Policy>
+AzAlt<typename Policy::Real> BasicCoordinateEngine<Policy>::horizontalRate(AzAlt<Real> position) const {
+	const Real sinLatitude = _matrix[2][2];
+	const Real cosLatitude = _matrix[0][2];
+	const Real az = toRadians(position.azimuth);
+	const Real alt = toRadians(position.altitude);
+	const Real rate = static_cast<Real>(SIDEREAL_DEGREES_PER_SECOND);
+
+	// Exactly at the zenith the azimuth rate is infinite. Keep it finite, the motor speed is limited anyway
+	Real cosAlt = Policy::cos(alt);
+	if (cosAlt < static_cast<Real>(1e-6)) {
+		cosAlt = static_cast<Real>(1e-6);
+	}
+
+	return {
+		rate * (sinLatitude - cosLatitude * Policy::cos(az) * Policy::sin(alt) / cosAlt),
+		rate * cosLatitude * Policy::sin(az)
+	};
+}
+
+
+template<typename Policy>
+void BasicCoordinateEngine<Policy>::toHorizontal(const RaDecPosition* positions, AzAlt<Real>* result, const unsigned int count) const {
+	for (unsigned int i = 0; i < count; i++) {
+		result[i] = toHorizontal(positions[i]);
+	}
+}
+
+
+template<typename Policy>
+void BasicCoordinateEngine<Policy>::rotateToHorizontal(const Real* __restrict__ x, const Real* __restrict__ y, const Real* __restrict__ z,
+	Real* __restrict__ north, Real* __restrict__ east, Real* __restrict__ up, const unsigned int count) const {
+	// Copies, so that the compiler knows that the outputs can not change the matrix
+	const Real m00 = _matrix[0][0], m01 = _matrix[0][1], m02 = _matrix[0][2];
+	const Real m10 = _matrix[1][0], m11 = _matrix[1][1];
+	const Real m20 = _matrix[2][0], m21 = _matrix[2][1], m22 = _matrix[2][2];
+
+	COORDINATE_ENGINE_VECTORIZE
+	for (unsigned int i = 0; i < count; i++) {
+		north[i] = m00 * x[i] + m01 * y[i] + m02 * z[i];
+		east[i] = m10 * x[i] + m11 * y[i];
+		up[i] = m20 * x[i] + m21 * y[i] + m22 * z[i];
+	}
+}
+
+
+template class BasicCoordinateEngine<Float32Policy>;
+template class BasicCoordinateEngine<LookupTablePolicy>;
+template class BasicCoordinateEngine<Float64Policy>;
+template class BasicCoordinateEngine<FixedPointPolicy>;
@@ -0,0 +1,93 @@
+#pragma once
+/*
+ * CoordinateEngine.h
+ *
+ * Converts between equatorial (Ra/Dec) and horizontal (Az/Alt) coordinates with a rotation matrix.
+ * The matrix depends only on the local sidereal time and the observer latitude, so it is built once
+ * per update and then applied to as many unit vectors as needed. Converting a target only costs
+ * the trig functions to go from/to a unit vector, and targets whose unit vector is already known
+ * (e.g. a catalog) can be rotated without any trig at all.
+ *
+ * The engine is templated on a numeric policy (see NumericPolicy.h), which decides the type of the
+ * matrix, vectors and angles. CoordinateEngine is the engine for the policy config.h selects for the board.
+ *
+ * Vectors are given in these frames:
+ * Equatorial: x points to Ra 0h, y to Ra 6h, z to the celestial north pole
+ * Horizontal: north, east, up (zenith). Azimuth is measured from north towards east
+ */
+
+#include "./config.h"
+#include "./location.h"
+#include "./Mount.h"
+#include "./NumericPolicy.h"
+#include "./Observer.h"
+#include "./SiderealClock.h"
+
+template<typename T>
+struct Vector3 {
+	T x;
+	T y;
+	T z;
+};
+
+template<typename Policy>
+class BasicCoordinateEngine {
+public:
+	typedef typename Policy::Real Real;
+	typedef Vector3<Real> Vector;
+
+	// Rebuilds the rotation matrix. Does nothing if neither the LST nor the observer position changed since the last call
+	void update(const double localSiderealTime, const ObserverTrigonometry& observer);
+
+	// Unit vector of a position given in Ra/Dec (degrees)
+	static Vector equatorialVector(RaDecPosition position);
+
+	// Converts Ra/Dec (degrees) to Az/Alt (degrees, 0 <= azimuth < 360)
+	AzAlt<Real> toHorizontal(RaDecPosition position) const;
+
+	// Converts an equatorial unit vector to Az/Alt (degrees, 0 <= azimuth < 360)
+	AzAlt<Real> toHorizontal(const Vector& equatorial) const;
+
+	// Converts Az/Alt (degrees) to Ra/Dec (degrees, 0 <= right ascension < 360)
+	RaDecPosition toEquatorial(AzAlt<Real> position) const;
+
+	// How fast a fixed Ra/Dec target currently at position (Az/Alt in degrees) moves, in degrees per second.
+	// The azimuth rate grows without limit towards the zenith
+	AzAlt<Real> horizontalRate(AzAlt<Real> position) const;
+
+	// Converts count positions from Ra/Dec to Az/Alt (all in degrees)
+	void toHorizontal(const RaDecPosition* positions, AzAlt<Real>* result, const unsigned int count) const;
+
+	// Rotates count equatorial unit vectors into the horizontal frame. The inputs and outputs are separate arrays
+	// per component, so that the host build can vectorize the loop. This does not call any trig functions.
+	// up[i] is the sine of the altitude, so a target is above the horizon if up[i] > 0
+	void rotateToHorizontal(const Real* x, const Real* y, const Real* z,
+		Real* north, Real* east, Real* up, const unsigned int count) const;
+
+	// The LST (degrees) the current matrix was built for
+	double localSiderealTime() const {
+		return _localSiderealTime;
+	}
+
+protected:
+	// Rows: north, east, up. Columns: equatorial x, y, z
+	Real _matrix[3][3] = {
+		{ 0., 0., 1. },
+		{ 0., 1., 0. },
+		{ 1., 0., 0. }
+	};
+
+	double _localSiderealTime = -1.;
+
+	// ObserverTrigonometry::version the matrix was built for. 0 means never built
+	unsigned int _observerVersion = 0;
+};
+
+// CoordinateEngine.cpp instantiates the engine for every policy, so that the host benchmark can compare them
+extern template class BasicCoordinateEngine<Float32Policy>;
+extern template class BasicCoordinateEngine<LookupTablePolicy>;
+extern template class BasicCoordinateEngine<Float64Policy>;
+extern template class BasicCoordinateEngine<FixedPointPolicy>;
+
+typedef COORDINATE_NUMERIC_POLICY CoordinatePolicy;
+typedef BasicCoordinateEngine<CoordinatePolicy> CoordinateEngine;
@@ -1,4 +1,3 @@
-#include <AccelStepper.h>
 #include <Time.h>
 
 #include "./config.h"
@@ -8,7 +7,7 @@
 #include "./DirectDrive.h"
 
 
-DirectDrive::DirectDrive(AccelStepper& azimuthStepper, AccelStepper& altitudeStepper, Observer &observer) :
+DirectDrive::DirectDrive(MountStepper& azimuthStepper, MountStepper& altitudeStepper, Observer &observer) :
 	_azimuthStepper(azimuthStepper), _altitudeStepper(altitudeStepper), _observer(observer) {
 }
 
@@ -34,26 +33,61 @@ void DirectDrive::calculateMotorTargets() {
 
 void DirectDrive::setAlignment(RaDecPosition alignment) {
 	// Set the steppers to the target position
-	_azimuthStepper.setCurrentPosition((long)(alignment.rightAscension * AZ_STEPS_PER_DEG));
-	_altitudeStepper.setCurrentPosition((long)(alignment.declination * ALT_STEPS_PER_DEG));
+	_steppersAligned = {
+		(long)(alignment.rightAscension * AZ_STEPS_PER_DEG),
+		(long)(alignment.declination * ALT_STEPS_PER_DEG)
+	};
+	// The queue can be full of moves. Then move() queues the alignment as soon as there is room
+	_alignmentPending = !queuePosition(_steppersAligned, true);
 	setTarget(alignment);
 }
 
 
+unsigned long DirectDrive::microsUntilUpdate() {
+	if (_alignmentPending) {
+		// Try again as soon as possible
+		return 0;
+	}
+	return Mount::microsUntilUpdate();
+}
+
+
+void DirectDrive::startSegment(const MotionSegment& segment, const unsigned long, const unsigned long) {
+	if (segment.mode != DRIVE_TO_POSITION) {
+		return;
+	}
+	if (segment.setPosition) {
+		_azimuthStepper.setCurrentPosition(segment.position.azimuth);
+		_altitudeStepper.setCurrentPosition(segment.position.altitude);
+	}
+	else {
+		_azimuthStepper.moveTo(segment.position.azimuth);
+		_altitudeStepper.moveTo(segment.position.altitude);
+	}
+}
+
+
 /*
  * This method gets executed every 10.000 loop iterations right after Dobson::calculateMotorTargets() was called.
  * It checks whether the telescope is homed. If it is NOT homed, it sets the target as its current motor positions and sets _isHomed to true.
  * The next time the method gets called, _isHomed is true , and the stepper motors are actually moved to their new required position.
  */
 void DirectDrive::move() {
+	// An alignment that did not fit into the motion queue goes first, so no move starts from the old stepper position
+	if (_alignmentPending) {
+		if (!queuePosition(_steppersAligned, true)) {
+			return;
+		}
+		_alignmentPending = false;
+	}
+
 	if ((millis() < 5000)) {
 		DEBUG_PRINTLN("Ignore move for first 5 seconds");
 		return;
 	}
 
-	// Move the steppers to their target positions
-	_azimuthStepper.moveTo(_steppersTarget.azimuth);
-	_altitudeStepper.moveTo(_steppersTarget.altitude);
+	// Move the steppers to their target positions. The stepper interrupt starts the move (see Mount::startDueSegments())
+	queuePosition(_steppersTarget, false);
 
 	_currentPosition = {
 		_target.rightAscension,
@@ -75,9 +109,10 @@ void DirectDrive::move() {
 			DEBUG_PRINT("");
 
 			DEBUG_PRINT("   Actual Steps ");
-			DEBUG_PRINT(_azimuthStepper.currentPosition());
+			const StepperSnapshot steppers = stepperSnapshot();
+			DEBUG_PRINT(steppers.position.azimuth);
 			DEBUG_PRINT("s / ");
-			DEBUG_PRINT(_altitudeStepper.currentPosition());
+			DEBUG_PRINT(steppers.position.altitude);
 			DEBUG_PRINT("s");
 
 			#ifndef DEBUG_TIMING
@@ -6,16 +6,15 @@
  *      Author: lukas
  */
 
-#include <AccelStepper.h>
-
 #include "./Mount.h"
 #include "./Observer.h"
 #include "./location.h"
+#include "./StepGenerator.h"
 
 
 class DirectDrive : public Mount {
 public:
-	DirectDrive(AccelStepper& azimuthStepper, AccelStepper& altitudeStepper, Observer& observer);
+	DirectDrive(MountStepper& azimuthStepper, MountStepper& altitudeStepper, Observer& observer);
 
 	// This runs at the very end of the Arduino setup() function and sets the operating mode and initial target
 	void initialize();
@@ -30,10 +29,14 @@ public:
 
 	void setAlignment(RaDecPosition alignment);
 
+	// 0 while an alignment waits for room in the motion queue
+	unsigned long microsUntilUpdate();
+
 	AzAlt<double> getMotorAngles() {
+		const StepperSnapshot steppers = stepperSnapshot();
 		return {
-			_azimuthStepper.currentPosition() / AZ_STEPS_PER_DEG,
-			_altitudeStepper.currentPosition() / ALT_STEPS_PER_DEG,
+			steppers.position.azimuth / AZ_STEPS_PER_DEG,
+			steppers.position.altitude / ALT_STEPS_PER_DEG,
 		};
 	}
 
@@ -48,14 +51,23 @@ public:
 
 protected:
 	// Reference to the azimuth stepper
-	AccelStepper& _azimuthStepper;
+	MountStepper& _azimuthStepper;
 
 	// Reference to the altitude stepper
-	AccelStepper& _altitudeStepper;
+	MountStepper& _altitudeStepper;
 
 	// Reference to the Observer
 	Observer& _observer;
 
 	// Target position for the steppers before the last move. It is written to at the end of move()
 	AzAlt<long> _steppersLastTarget;
+
+	// The stepper position set by the last alignment (in steps)
+	AzAlt<long> _steppersAligned = { 0, 0 };
+
+	// setAlignment() could not queue the segment that sets the stepper position to _steppersAligned. move() queues it
+	bool _alignmentPending = false;
+
+	// Starts a queued segment. Called by the stepper interrupt, see Mount::startDueSegments(). This mount only moves to positions
+	void startSegment(const MotionSegment& segment, const unsigned long lateMicros, const unsigned long elapsedMicros);
 };
@@ -1,4 +1,3 @@
-#include <AccelStepper.h>
 #include <FuGPS.h>
 #include <Time.h>
 
@@ -28,8 +27,9 @@ void nclamp360(double& value) {
 }
 
 
-Dobson::Dobson(AccelStepper &azimuthStepper, AccelStepper &altitudeStepper, Observer &observer) :
-		_azimuthStepper(azimuthStepper), _altitudeStepper(altitudeStepper), _observer(observer) {
+Dobson::Dobson(MountStepper &azimuthStepper, MountStepper &altitudeStepper, Observer &observer) :
+		_azimuthStepper(azimuthStepper), _altitudeStepper(altitudeStepper), _observer(observer),
+		_azimuthScale(CoordinatePolicy::stepScale(AZ_STEPS_PER_DEG)), _altitudeScale(CoordinatePolicy::stepScale(ALT_STEPS_PER_DEG)) {
 }
 
 
@@ -44,51 +44,52 @@ void Dobson::initialize() {
 
 
 /*
- * Converts from Right Ascension and Declination (Horizontal) to Azimuth and Altitude (Equatorial) coordinates
+ * Builds the rotation matrix of the coordinate engine for the current local sidereal time.
+ * Everything that converts coordinates in this update uses the same matrix
  */
-AzAlt<double> Dobson::raDecToAltAz(RaDecPosition target) {
-	// Update LST
-	_currentLocalSiderealTime = get_local_sidereal_time(_observer.longitude());
-	double ha = _currentLocalSiderealTime - target.rightAscension; // in degrees
-	if (ha < 0.) {
-		ha += 360.;
-	}
-
-	const double h1 = radians(ha);
-	const double d = radians(target.declination);
-	const double lat = radians(_observer.latitude());
-
-	const double sinA = sin(d) * sin(lat) + cos(d) * cos(lat) * cos(h1);
-	const double alt = degrees(asin(sinA));
-
-	const double y = 0.-cos(d) * cos(lat) * sin(h1);
-	const double x = sin(d) - sin(lat) * sinA;
+void Dobson::updateCoordinateEngine() {
+	_currentLocalSiderealTime = _observer.localSiderealTime();
+	_coordinateEngine.update(_currentLocalSiderealTime, _observer.trigonometry());
+}
 
-	const double upperA = atan2(y, x);
-	double upperB = degrees(upperA);
 
-	if (upperB < 0.) {
-		upperB += 360.;
-	}
-
-	return { upperB, alt };
+/*
+ * Converts from Right Ascension and Declination (Horizontal) to Azimuth and Altitude (Equatorial) coordinates
+ */
+AzAlt<double> Dobson::raDecToAltAz(RaDecPosition target) {
+	updateCoordinateEngine();
+	const AzAlt<CoordinateEngine::Real> result = _coordinateEngine.toHorizontal(target);
+	return { result.azimuth, result.altitude };
 }
 
 /*
  * Calculates motor target angles by converting from Right Ascension and Declination to Azimuth and Altitude.
  * No movement of the motors is performed in this method (see Dobson::move() for that part)
- * The basic formulas are as follows:
- * Altitude = asin( sin(dec) * sin(lat) + cos(dec) * cos(lat) * cos(HourAngle) )
- * Azimuth  = acos( (sin(dec) - sin(lat) * sin(alt)) / (cos(lat) * cos(Altitude)) )
- * If sin(HourAngle) > 0 then Azimuth = 360 - Azimuth
+ * The conversion rotates the unit vector of the target with the matrix of the CoordinateEngine. See CoordinateEngine.cpp for the formulas
  */
 void Dobson::calculateMotorTargets() {
-	_targetDegrees = raDecToAltAz(_target);
+	updateCoordinateEngine();
+
+	// While tracking along a trajectory, the target is simply read from it
+	if (!targetFromTrajectory()) {
+		// The unit vector of the target only changes when a new target is set
+		if (_target.rightAscension != _targetVectorSource.rightAscension
+			|| _target.declination != _targetVectorSource.declination) {
+			_targetVector = CoordinateEngine::equatorialVector(_target);
+			_targetVectorSource = _target;
+		}
+		_targetDegrees = _coordinateEngine.toHorizontal(_targetVector);
 
-	_steppersTarget = {
-		_targetDegrees.azimuth * AZ_STEPS_PER_DEG,
-		_targetDegrees.altitude * ALT_STEPS_PER_DEG
-	};
+		#ifdef TRACKING_VELOCITY_FEED_FORWARD
+			_targetRate = _coordinateEngine.horizontalRate(_targetDegrees);
+		#endif
+
+		const long altitude = CoordinatePolicy::toSteps(_targetDegrees.altitude, _altitudeScale);
+		_steppersTarget = {
+			unwrapAzimuth(CoordinatePolicy::toSteps(_targetDegrees.azimuth, _azimuthScale), altitude),
+			altitude
+		};
+	}
 
 	if (_steppersTarget.azimuth != _steppersLastTarget.azimuth
 		|| _steppersTarget.altitude != _steppersLastTarget.altitude) {
@@ -103,9 +104,11 @@ void Dobson::calculateMotorTargets() {
 	}
 
 	// Azimuth / Altitude to RightAscension / Declination and store the result
-	_currentPosition = azAltToRaDec({
-		_azimuthStepper.currentPosition() / AZ_STEPS_PER_DEG,
-		_altitudeStepper.currentPosition() / ALT_STEPS_PER_DEG
+	// Both axes come from the same stepper interrupt (see Mount::stepperSnapshot())
+	const StepperSnapshot steppers = stepperSnapshot();
+	_currentPosition = _coordinateEngine.toEquatorial({
+		CoordinatePolicy::toDegrees(steppers.position.azimuth, _azimuthScale),
+		CoordinatePolicy::toDegrees(steppers.position.altitude, _altitudeScale)
 	});
 
 	#ifdef DEBUG_TIMING
@@ -120,25 +123,131 @@ void Dobson::calculateMotorTargets() {
 void Dobson::setAlignment(RaDecPosition alignment) {
 	AzAlt<double> alignmentAzAlt = raDecToAltAz(alignment);
 
-	// Set the steppers to the target position
-	_azimuthStepper.setCurrentPosition((long)(alignmentAzAlt.azimuth * AZ_STEPS_PER_DEG));
-	_altitudeStepper.setCurrentPosition((long)(alignmentAzAlt.altitude * ALT_STEPS_PER_DEG));
+	#ifdef SLEW_PLANNER
+		// The segment below replaces the queued phases of a slew
+		_slewing = false;
+	#endif
+
+	// Set the steppers to the target position. The cables are not wound up there
+	_steppersHomed = {
+		CoordinatePolicy::toSteps(alignmentAzAlt.azimuth, _azimuthScale),
+		CoordinatePolicy::toSteps(alignmentAzAlt.altitude, _altitudeScale)
+	};
+	// The queue can be full of slew phases or trajectories. Then move() queues the alignment as soon as there is room
+	_alignmentPending = !queuePosition(_steppersHomed, true);
 	setTarget(alignment);
 }
 
 
+/*
+ * The azimuth is the same one revolution lower and higher. While tracking, the revolution closest to the current position
+ * is simply kept. Otherwise the estimated slew times decide (see SlewPlanner::slewSeconds()), and revolutions beyond the
+ * cable wrap limit are left out. The revolution closest to where the steppers were homed is always within the limit
+ */
+long Dobson::unwrapAzimuth(const long azimuth, const long altitude) {
+	const long revolution = static_cast<long>(AZ_STEPS_PER_REV);
+	const AzAlt<long> position = stepperSnapshot().position;
+	const long closest = azimuth + static_cast<long>(floor((position.azimuth - azimuth) / (double)revolution + 0.5)) * revolution;
+	if (labs(closest - position.azimuth) <= (long)(TRACKING_MAX_ERROR * AZ_STEPS_PER_DEG) && isWithinCableWrap(closest)) {
+		return closest;
+	}
+
+	long best = azimuth + static_cast<long>(floor((_steppersHomed.azimuth - azimuth) / (double)revolution + 0.5)) * revolution;
+	double bestSeconds = SlewPlanner::slewSeconds({ best - position.azimuth, altitude - position.altitude });
+	for (long candidate = closest - revolution; candidate <= closest + revolution; candidate += revolution) {
+		if (candidate == best || !isWithinCableWrap(candidate)) {
+			continue;
+		}
+		const double seconds = SlewPlanner::slewSeconds({ candidate - position.azimuth, altitude - position.altitude });
+		if (seconds < bestSeconds) {
+			best = candidate;
+			bestSeconds = seconds;
+		}
+	}
+	return best;
+}
+
+
+bool Dobson::isWithinCableWrap(const long azimuth) {
+#ifdef AZ_CABLE_WRAP_DEG
+	return labs(azimuth - _steppersHomed.azimuth) <= (long)(AZ_CABLE_WRAP_DEG * AZ_STEPS_PER_DEG);
+#else
+	return true;
+#endif
+}
+
+
+/*
+ * Runs in the stepper interrupt, so the steppers never see a half written target or speed.
+ * A trajectory catches up with the time since the start of the segment
+ */
+void Dobson::startSegment(const MotionSegment& segment, const unsigned long lateMicros, const unsigned long elapsedMicros) {
+	switch (segment.mode) {
+	case DRIVE_TO_POSITION:
+		if (segment.setPosition) {
+			_azimuthStepper.setCurrentPosition(segment.position.azimuth);
+			_altitudeStepper.setCurrentPosition(segment.position.altitude);
+		}
+		else {
+			// run() takes over from the current speed
+			_azimuthStepper.moveTo(segment.position.azimuth);
+			_altitudeStepper.moveTo(segment.position.altitude);
+		}
+		break;
+	case DRIVE_AT_SPEED:
+		_azimuthStepper.setSpeed(segment.speed.azimuth);
+		_altitudeStepper.setSpeed(segment.speed.altitude);
+		break;
+	case DRIVE_ALONG_TRAJECTORY:
+	#if defined TRACKING_TRAJECTORY || defined SLEW_PLANNER
+		_azimuthTrajectory = segment.azimuthTrajectory;
+		_altitudeTrajectory = segment.altitudeTrajectory;
+		{
+			// The segment continues where it would be by now. Unless it is so late that the interrupt must have been stopped in between.
+			// Then it only skips Trajectory::MAX_ADVANCE_TICKS, and the axes stay behind until the main loop starts the next segment
+			const unsigned long lateTicks = lateMicros / STEPPER_INTERRUPT_FREQ;
+			const unsigned long skippedTicks = lateTicks < Trajectory::MAX_ADVANCE_TICKS ? lateTicks : Trajectory::MAX_ADVANCE_TICKS;
+			_azimuthTrajectory.advance(skippedTicks);
+			_altitudeTrajectory.advance(skippedTicks);
+		#ifdef STEP_GENERATOR
+			// stepAlongTrajectory() adds elapsedMicros right after this, which leaves the rest of lateMicros (unsigned wrap around)
+			_trajectoryElapsed = (skippedTicks == lateTicks ? lateMicros % STEPPER_INTERRUPT_FREQ : 0) - elapsedMicros;
+		#else
+			// Makes stepAlongTrajectory() set the direction of the steppers again
+			_azimuthDirection = 0;
+			_altitudeDirection = 0;
+		#endif
+		}
+	#endif
+		break;
+	}
+}
+
+
 /*
  * This method gets executed every 10.000 loop iterations right after Dobson::calculateMotorTargets() was called.
  * It checks whether the telescope is homed. If it is NOT homed, it sets the target as its current motor positions and sets _isHomed to true.
  * The next time the method gets called, _isHomed is true , and the stepper motors are actually moved to their new required position.
  */
 void Dobson::move() {
+	// The steppers are only changed by the stepper interrupt, through the motion queue. If the queue is full,
+	// _steppersLastTarget stays as it is and the next call tries again
+	bool queued = true;
+
+	// An alignment that did not fit into the motion queue goes first. Nothing is queued before it, as all other
+	// segments are relative to the stepper position it sets
+	if (_alignmentPending) {
+		if (!queuePosition(_steppersHomed, true)) {
+			return;
+		}
+		_alignmentPending = false;
+	}
+
 		// TODO Finally find a relaible way to start the scope. 
 	if (millis() < 3000) {//_ignoreMoves || !_isHomed) {
 		// If not homed, or if homing was performed in this loop iteration just
 		// set the current stepper position to the current target position without moving them
-		_azimuthStepper.setCurrentPosition(_steppersTarget.azimuth);
-		_altitudeStepper.setCurrentPosition(_steppersTarget.altitude);
+		queued = queuePosition(_steppersTarget, true);
 
 		// Store where the motors targeted before this operation, in case we need to move back to the original position.
 		_steppersHomed = { _steppersTarget.azimuth, _steppersTarget.altitude };
@@ -149,16 +258,22 @@ void Dobson::move() {
 		_ignoredMoveLastIteration = true;
 	} else {
 		_ignoredMoveLastIteration = false;
-		if (_didMove) {
+	#ifdef SLEW_PLANNER
+		if (continueSlew()) {
+			// Nothing else moves the steppers until the slew is over. If the target moved meanwhile, it is moved to afterwards
+			return;
+		}
+	#endif
+		// After tracking, the targets of the steppers are stale, even if the target did not move
+		if (!track() && (_didMove || _queuedDriveMode != DRIVE_TO_POSITION)) {
 			// Move the steppers to their target positions
-			_azimuthStepper.moveTo(_steppersTarget.azimuth);
-			_altitudeStepper.moveTo(_steppersTarget.altitude);
+			queued = queueMove(_steppersTarget);
 		}
 	}
 
 	// Has the motor position changed since the last time move() was called? If so,
 	// store the current target value
-	if (_didMove) {
+	if (_didMove && queued) {
 
 		// Difference between the last target and the current one
 		debugMove(
@@ -173,34 +288,405 @@ void Dobson::move() {
 
 
 /*
- * This method converts from Azimuth and Altitude (Equatorial) to Right Ascension and Declination (Horizontal)
- * The values in the "position" parameter are expected to be in degrees
+ * An update only changes something once the target has moved by a whole step. While the steppers move to a target
+ * or slew, and while tracking at a speed, the usual interval is kept: the slew phases have to be queued as the motion queue
+ * empties, tracking starts once the steppers have arrived, and the speed correction depends on the interval.
+ * Along trajectories, the next update is due when the next trajectory has to be queued (see track()).
+ * Otherwise, the time until the next step follows from the angular rates of the target. That is many seconds near the pole
+ * and a few milliseconds near the zenith, where the azimuth rate gets very large
  */
-RaDecPosition Dobson::azAltToRaDec(AzAlt<double> position) {
-	const double az = radians(position.azimuth);
-	const double alt = radians(position.altitude);
-	const double lat = radians(_observer.latitude());
+unsigned long Dobson::microsUntilUpdate() {
+	const unsigned long interval = UPDATE_MOTOR_POS_MS * 1000UL;
+	if (_alignmentPending) {
+		// Try again as soon as possible
+		return 0;
+	}
+	if (_ignoredMoveLastIteration) {
+		return interval;
+	}
+	#ifdef SLEW_PLANNER
+		if (_slewing) {
+			return interval;
+		}
+	#endif
+
+	switch (_queuedDriveMode) {
+	case DRIVE_AT_SPEED:
+		return interval;
+	case DRIVE_ALONG_TRAJECTORY:
+	#ifdef TRACKING_TRAJECTORY
+		if (!isTrajectoryStale()) {
+			const unsigned long queueAt = _trajectorySegment.startMicros + (TRAJECTORY_REFIT_MS - MOTION_QUEUE_AHEAD_MS) * 1000UL;
+			const long wait = (long)(queueAt - micros());
+			return wait > 0 ? wait : 0;
+		}
+	#endif
+		return interval;
+	default:
+		break;
+	}
+
+	const StepperSnapshot steppers = stepperSnapshot();
+	if (!_motionQueue.isEmpty()
+		|| steppers.position.azimuth != _queuedPosition.azimuth || steppers.position.altitude != _queuedPosition.altitude) {
+		return interval;
+	}
+
+	const AzAlt<CoordinateEngine::Real> rate = _coordinateEngine.horizontalRate(_targetDegrees);
+	const double azimuthSeconds = secondsUntilStep(_targetDegrees.azimuth * AZ_STEPS_PER_DEG, rate.azimuth * AZ_STEPS_PER_DEG);
+	const double altitudeSeconds = secondsUntilStep(_targetDegrees.altitude * ALT_STEPS_PER_DEG, rate.altitude * ALT_STEPS_PER_DEG);
+	const double seconds = azimuthSeconds < altitudeSeconds ? azimuthSeconds : altitudeSeconds;
+	// The limits of Mount::scheduleUpdate() apply anyway. This only keeps the conversion from overflowing
+	return seconds < UPDATE_MOTOR_POS_MAX_MS / 1000. ? static_cast<unsigned long>(seconds * 1000000.) : UPDATE_MOTOR_POS_MAX_MS * 1000UL;
+}
+
+
+/*
+ * The conversion to steps truncates, so the steps change at whole numbers. A target exactly on a step is one step
+ * away from the next one when moving up, and changes right away when moving down
+ */
+double Dobson::secondsUntilStep(const double position, const double rate) {
+	if (rate == 0.) {
+		return UPDATE_MOTOR_POS_MAX_MS / 1000.;
+	}
+	const double fraction = position - floor(position);
+	const double distance = rate > 0. ? 1. - fraction : fraction;
+	return distance / fabs(rate);
+}
+
+
+/*
+ * Tracking, once the steppers have arrived at the target (see the tracking section in config.h)
+ *
+ * Velocity feed-forward (TRACKING_VELOCITY_FEED_FORWARD):
+ * Each stepper runs at the rate the target moves at (the feed-forward), plus TRACKING_CORRECTION_GAIN times the
+ * remaining position error per second. The steppers follow the target smoothly between two updates, instead of
+ * accelerating to each new target position and waiting for the next one.
+ *
+ * Trajectory (TRACKING_TRAJECTORY):
+ * The stepper interrupt follows the trajectory polynomials (see startTrajectories()). A new trajectory segment starts every
+ * TRAJECTORY_REFIT_MS, and is queued MOTION_QUEUE_AHEAD_MS before it starts. If the target or the observer position changed,
+ * one that starts right away replaces the queued ones.
+ *
+ * Large errors (a new target, or the first move after aligning) are left to queueMove(). Tracking only starts once
+ * both steppers have arrived at their target, so that there is no jump in speed
+ */
+bool Dobson::track() {
+#if defined TRACKING_VELOCITY_FEED_FORWARD || defined TRACKING_TRAJECTORY
+	const StepperSnapshot steppers = stepperSnapshot();
+	const long azimuthError = _steppersTarget.azimuth - steppers.position.azimuth;
+	const long altitudeError = _steppersTarget.altitude - steppers.position.altitude;
+
+	const bool withinLimits = _mode == Mode::TRACKING
+		&& labs(azimuthError) <= (long)(TRACKING_MAX_ERROR * AZ_STEPS_PER_DEG)
+		&& labs(altitudeError) <= (long)(TRACKING_MAX_ERROR * ALT_STEPS_PER_DEG);
+	const bool arrived = _motionQueue.isEmpty()
+		&& steppers.position.azimuth == _queuedPosition.azimuth && steppers.position.altitude == _queuedPosition.altitude;
+	const bool tracking = _queuedDriveMode != DRIVE_TO_POSITION;
+
+	if (!withinLimits || (!tracking && !arrived)) {
+		return false;
+	}
+
+	#ifdef TRACKING_VELOCITY_FEED_FORWARD
+		MotionSegment segment;
+		segment.mode = DRIVE_AT_SPEED;
+		segment.speed = {
+			static_cast<float>(_targetRate.azimuth * AZ_STEPS_PER_DEG + TRACKING_CORRECTION_GAIN * azimuthError),
+			static_cast<float>(_targetRate.altitude * ALT_STEPS_PER_DEG + TRACKING_CORRECTION_GAIN * altitudeError)
+		};
+		queueSegmentNow(segment);
+	#else
+		const unsigned long now = micros();
+		if (!tracking || isTrajectoryStale()) {
+			startTrajectories(now);
+		}
+		else {
+			// The next segment starts where the newest one ends. Unless the main loop was too slow for that
+			const unsigned long next = _trajectorySegment.startMicros + TRAJECTORY_REFIT_MS * 1000UL;
+			if ((long)(next - now) < MOTION_QUEUE_AHEAD_MS * 1000L) {
+				startTrajectories((long)(next - now) > 0 ? next : now);
+			}
+		}
+	#endif
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+#ifdef TRACKING_TRAJECTORY
+bool Dobson::isTrajectoryStale() {
+	return _target.rightAscension != _trajectoryTarget.rightAscension
+		|| _target.declination != _trajectoryTarget.declination
+		|| _observer.trigonometry().version != _trajectoryObserverVersion;
+}
+
+
+/*
+ * Converts the target at the TRAJECTORY_SAMPLES sample times of the TRAJECTORY_WINDOW_MS from startMicros and fits the
+ * trajectory polynomials of both axes to the resulting step positions. This is the only place that needs the
+ * trig functions for the target while tracking along trajectories.
+ * The azimuth is kept on the revolution of _steppersTarget (see unwrapAzimuth()), so that crossing north does not make the polynomial jump
+ */
+void Dobson::startTrajectories(const unsigned long startMicros) {
+	const double untilStart = (long)(startMicros - micros()) / 1000000.;
+	const double startLocalSiderealTime = _observer.localSiderealTime() + SIDEREAL_DEGREES_PER_SECOND * untilStart;
+	const double window = TRAJECTORY_WINDOW_MS / 1000.;
+
+	double times[TRAJECTORY_SAMPLES];
+	double azimuth[TRAJECTORY_SAMPLES];
+	double altitude[TRAJECTORY_SAMPLES];
+	Trajectory::sampleTimes(window, times);
+
+	const double currentAzimuth = _steppersTarget.azimuth;
+	for (int i = 0; i < TRAJECTORY_SAMPLES; i++) {
+		double localSiderealTime = startLocalSiderealTime + SIDEREAL_DEGREES_PER_SECOND * times[i];
+		if (localSiderealTime >= 360.) {
+			localSiderealTime -= 360.;
+		}
+		else if (localSiderealTime < 0.) {
+			localSiderealTime += 360.;
+		}
+		_coordinateEngine.update(localSiderealTime, _observer.trigonometry());
+		const AzAlt<CoordinateEngine::Real> position = _coordinateEngine.toHorizontal(_targetVector);
+
+		azimuth[i] = position.azimuth * AZ_STEPS_PER_DEG;
+		while (azimuth[i] - currentAzimuth > AZ_STEPS_PER_REV / 2.) {
+			azimuth[i] -= AZ_STEPS_PER_REV;
+		}
+		while (azimuth[i] - currentAzimuth < -AZ_STEPS_PER_REV / 2.) {
+			azimuth[i] += AZ_STEPS_PER_REV;
+		}
+		altitude[i] = position.altitude * ALT_STEPS_PER_DEG;
+	}
+	// Everything else expects the matrix of the current time
+	updateCoordinateEngine();
+
+	MotionSegment segment;
+	segment.startMicros = startMicros;
+	segment.mode = DRIVE_ALONG_TRAJECTORY;
+	segment.azimuthTrajectory.fit(times, azimuth);
+	segment.altitudeTrajectory.fit(times, altitude);
+
+	const double tickSeconds = STEPPER_INTERRUPT_FREQ / 1000000.;
+	segment.azimuthTrajectory.start(0., tickSeconds, window);
+	segment.altitudeTrajectory.start(0., tickSeconds, window);
+
+	// If the queue is full, the next update tries again
+	if (!queueSegment(segment)) {
+		return;
+	}
+
+	_trajectorySegment = segment;
+	_trajectoryTarget = _target;
+	_trajectoryObserverVersion = _observer.trigonometry().version;
+}
+
 
-	const double sinDec = sin(alt) * sin(lat) + cos(alt) * cos(lat) * cos(az);
-	const double dec = degrees(asin(sinDec));
+bool Dobson::targetFromTrajectory() {
+	if (_queuedDriveMode != DRIVE_ALONG_TRAJECTORY || isTrajectoryStale()) {
+		return false;
+	}
+
+	// Negative while the newest segment is queued ahead. Its polynomial is just as good shortly before its window
+	const double seconds = (long)(micros() - _trajectorySegment.startMicros) / 1000000.;
+	const AzAlt<long> target = {
+		(long)floor(_trajectorySegment.azimuthTrajectory.positionAt(seconds)),
+		(long)floor(_trajectorySegment.altitudeTrajectory.positionAt(seconds))
+	};
+	if (!isWithinCableWrap(target.azimuth)) {
+		// The conversion moves the target to another revolution, and the steppers slew there
+		return false;
+	}
+	_steppersTarget = target;
+	_targetDegrees = {
+		CoordinatePolicy::toDegrees(_steppersTarget.azimuth, _azimuthScale),
+		CoordinatePolicy::toDegrees(_steppersTarget.altitude, _altitudeScale)
+	};
+	return true;
+}
+#else
+bool Dobson::targetFromTrajectory() {
+	return false;
+}
+#endif
+
+
+#if defined TRACKING_TRAJECTORY || defined SLEW_PLANNER
+#ifdef STEP_GENERATOR
+/*
+ * Makes a step towards the trajectory, if it is due. Returns the microseconds until the next step of the axis is due:
+ * after 1 / max speed while it is behind the trajectory, otherwise at the tick in which the trajectory reaches the next step
+ */
+static unsigned long followTrajectory(StepGenerator& stepper, const Trajectory& trajectory,
+		const unsigned long elapsedMicros, const unsigned long sinceTick) {
+	const unsigned long wait = stepper.stepTowards(trajectory.target(), elapsedMicros);
+	if (wait != NO_STEP_DUE) {
+		return wait;
+	}
 
-	const double y = -cos(alt) * cos(lat) * sin(az);
-	const double x = sin(alt) - sin(lat) * sinDec;
+	const unsigned long ticks = trajectory.ticksUntilStep(stepper.currentPosition(), STEP_TIMER_MAX_MICROS / STEPPER_INTERRUPT_FREQ + 1);
+	const unsigned long tickMicros = ticks * STEPPER_INTERRUPT_FREQ;
+	return tickMicros > sinceTick ? tickMicros - sinceTick : 0;
+}
 
-	const double upperHA = atan2(y, x);
-	double ha = degrees(upperHA);
 
-	if (ha < 0.) {
-		ha += 360.;
+static_assert(STEP_TIMER_MAX_MICROS / STEPPER_INTERRUPT_FREQ < Trajectory::MAX_ADVANCE_TICKS, "The stepper interrupt must not skip more than Trajectory::MAX_ADVANCE_TICKS");
+
+/*
+ * The trajectories advance in whole ticks of STEPPER_INTERRUPT_FREQ microseconds. The rest of the elapsed time is
+ * carried over to the next call, so the interrupt can be scheduled for exactly the tick of the next step
+ */
+unsigned long Dobson::stepAlongTrajectory(const unsigned long elapsedMicros) {
+	_trajectoryElapsed += elapsedMicros;
+	const unsigned long ticks = _trajectoryElapsed / STEPPER_INTERRUPT_FREQ;
+	_trajectoryElapsed -= ticks * STEPPER_INTERRUPT_FREQ;
+	_azimuthTrajectory.advance(ticks);
+	_altitudeTrajectory.advance(ticks);
+
+	const unsigned long azimuthWait = followTrajectory(_azimuthStepper, _azimuthTrajectory, elapsedMicros, _trajectoryElapsed);
+	const unsigned long altitudeWait = followTrajectory(_altitudeStepper, _altitudeTrajectory, elapsedMicros, _trajectoryElapsed);
+	return azimuthWait < altitudeWait ? azimuthWait : altitudeWait;
+}
+#else
+// Makes at most one step towards target. runSpeed() keeps the steps at least 1 / max speed apart
+static void stepTowards(MountStepper& stepper, const long target, int8_t& direction) {
+	const long position = stepper.currentPosition();
+	if (target == position) {
+		return;
 	}
 
-	const double h1 = _currentLocalSiderealTime - ha;
-	double ra = h1;
-	if (h1 < 0.) {
-		ra += 360.;
+	const int8_t targetDirection = target > position ? 1 : -1;
+	if (targetDirection != direction) {
+		stepper.setSpeed(targetDirection * stepper.maxSpeed());
+		direction = targetDirection;
 	}
+	stepper.runSpeed();
+}
 
-	return { ra, dec };
+
+void Dobson::stepAlongTrajectory() {
+	stepTowards(_azimuthStepper, _azimuthTrajectory.nextTick(), _azimuthDirection);
+	stepTowards(_altitudeStepper, _altitudeTrajectory.nextTick(), _altitudeDirection);
+}
+#endif
+#endif
+
+
+/*
+ * Small moves are left to run(), which takes over from the current speed. A slew starts from standstill,
+ * which the steppers are close to after arriving at a target or while tracking.
+ * It goes to where the target will be at the end of the slew, so that tracking can start right away
+ */
+bool Dobson::queueMove(const AzAlt<long> position) {
+#ifdef SLEW_PLANNER
+	const AzAlt<long> from = stepperSnapshot().position;
+	if (labs(position.azimuth - from.azimuth) > (long)(TRACKING_MAX_ERROR * AZ_STEPS_PER_DEG)
+		|| labs(position.altitude - from.altitude) > (long)(TRACKING_MAX_ERROR * ALT_STEPS_PER_DEG)) {
+		return startSlew(from, targetAtArrival(from, position));
+	}
+#endif
+	return queuePosition(position, false);
+}
+
+
+#ifdef SLEW_PLANNER
+/*
+ * The slew time depends on where the target will be, and the other way around. Starting with the slew time to where the
+ * target is now, this converts the target for the end of the slew and estimates the slew time to there again.
+ * The target moves slowly compared to the slew, so each iteration makes the error a lot smaller. Three are plenty.
+ * The azimuth stays on the revolution of position (see unwrapAzimuth())
+ */
+AzAlt<long> Dobson::targetAtArrival(const AzAlt<long> from, const AzAlt<long> position) {
+	const long revolution = static_cast<long>(AZ_STEPS_PER_REV);
+	AzAlt<long> target = position;
+	for (uint8_t i = 0; i < 3; i++) {
+		const double seconds = SlewPlanner::slewSeconds({ target.azimuth - from.azimuth, target.altitude - from.altitude });
+		double localSiderealTime = _currentLocalSiderealTime + SIDEREAL_DEGREES_PER_SECOND * seconds;
+		if (localSiderealTime >= 360.) {
+			localSiderealTime -= 360.;
+		}
+		_coordinateEngine.update(localSiderealTime, _observer.trigonometry());
+		const AzAlt<CoordinateEngine::Real> degrees = _coordinateEngine.toHorizontal(_targetVector);
+
+		const long azimuth = CoordinatePolicy::toSteps(degrees.azimuth, _azimuthScale);
+		target = {
+			azimuth + static_cast<long>(floor((position.azimuth - azimuth) / (double)revolution + 0.5)) * revolution,
+			CoordinatePolicy::toSteps(degrees.altitude, _altitudeScale)
+		};
+	}
+	// Everything else expects the matrix of the current time
+	updateCoordinateEngine();
+	return target;
+}
+
+
+/*
+ * The first phase starts right away and replaces whatever is queued. If the queue is full, the next update tries again
+ */
+bool Dobson::startSlew(const AzAlt<long> from, const AzAlt<long> to) {
+	if (!_slew.plan(from, to) || _motionQueue.isFull()) {
+		return false;
+	}
+	_slewing = true;
+	_slewStartMicros = micros();
+	_slewQueuedPhases = 0;
+	continueSlew();
+	return true;
+}
+
+
+/*
+ * Each phase is queued as a trajectory segment that starts at the beginning of the phase. After the last one, a
+ * DRIVE_TO_POSITION segment at the end position makes run() take over, so that arriving works as after any other move.
+ * A phase queued after its start time catches up in the stepper interrupt (see startSegment())
+ */
+bool Dobson::continueSlew() {
+	if (!_slewing) {
+		return false;
+	}
+
+	const double tickSeconds = STEPPER_INTERRUPT_FREQ / 1000000.;
+	while (_slewQueuedPhases <= _slew.phases()) {
+		const unsigned long startMicros = _slewStartMicros + (unsigned long)(_slew.phaseStart(_slewQueuedPhases) * 1000000.);
+		if (_slewQueuedPhases < _slew.phases()) {
+			MotionSegment segment;
+			segment.startMicros = startMicros;
+			segment.mode = DRIVE_ALONG_TRAJECTORY;
+			_slew.phaseTrajectories(_slewQueuedPhases, tickSeconds, segment.azimuthTrajectory, segment.altitudeTrajectory);
+			if (!queueSegment(segment)) {
+				return true;
+			}
+		}
+		else if (!queuePosition(_slew.target(), false, startMicros)) {
+			return true;
+		}
+		_slewQueuedPhases++;
+	}
+
+	// Over once the end position has been started
+	if (!_motionQueue.isEmpty()) {
+		return true;
+	}
+	_slewing = false;
+	return false;
+}
+#endif
+
+
+/*
+ * This method converts from Azimuth and Altitude (Equatorial) to Right Ascension and Declination (Horizontal)
+ * The values in the "position" parameter are expected to be in degrees
+ */
+RaDecPosition Dobson::azAltToRaDec(AzAlt<double> position) {
+	// Uses the matrix of the last raDecToAltAz() / calculateMotorTargets() call
+	return _coordinateEngine.toEquatorial({
+		static_cast<CoordinateEngine::Real>(position.azimuth),
+		static_cast<CoordinateEngine::Real>(position.altitude)
+	});
 }
 
 /*
@@ -255,9 +741,10 @@ void Dobson::debugMove(long diffAz, long diffAlt) {
 		DEBUG_PRINT(" / ");
 		DEBUG_PRINT(diffAlt);
 		DEBUG_PRINT("°; Reported: az");
-		DEBUG_PRINT(_azimuthStepper.currentPosition());
+		const StepperSnapshot reported = stepperSnapshot();
+		DEBUG_PRINT(reported.position.azimuth);
 		DEBUG_PRINT("/dec ");
-		DEBUG_PRINT(_altitudeStepper.currentPosition());
+		DEBUG_PRINT(reported.position.altitude);
 	#elif defined DEBUG_SERIAL_STEPPER_MOVEMENT
 		// Desired position in Ra/Dec
 		DEBUG_PRINT("Desired:\t");
@@ -330,14 +817,16 @@ void Dobson::debugMove(long diffAz, long diffAlt) {
 		DEBUG_PRINT(_currentPosition.declination);
 		DEBUG_PRINT("°\t\t");
 
-		DEBUG_PRINT(_azimuthStepper.currentPosition() / AZ_STEPS_PER_DEG);
+		// One snapshot, so that the degrees and steps are of the same moment
+		const StepperSnapshot steppers = stepperSnapshot();
+		DEBUG_PRINT(steppers.position.azimuth / AZ_STEPS_PER_DEG);
 		DEBUG_PRINT("°\t");
-		DEBUG_PRINT(_altitudeStepper.currentPosition() / ALT_STEPS_PER_DEG);
+		DEBUG_PRINT(steppers.position.altitude / ALT_STEPS_PER_DEG);
 		DEBUG_PRINT("°\t\t");
 
-		DEBUG_PRINT(_azimuthStepper.currentPosition());
+		DEBUG_PRINT(steppers.position.azimuth);
 		DEBUG_PRINT("°\t");
-		DEBUG_PRINT(_altitudeStepper.currentPosition());
+		DEBUG_PRINT(steppers.position.altitude);
 		DEBUG_PRINTLN("°");
 	#endif
 
@@ -6,32 +6,36 @@
  *      Author: lukas
  */
 
-#include <AccelStepper.h>
 #include <FuGPS.h>
 
+#include "./CoordinateEngine.h"
 #include "./location.h"
 #include "./Observer.h"
+#include "./SlewPlanner.h"
+#include "./StepGenerator.h"
+#include "./Trajectory.h"
 
 #include "./Mount.h"
 
 class Dobson: public Mount {
 public:
-	Dobson(AccelStepper &azimuthStepper, AccelStepper &altitudeSteppers, Observer &observer);
+	Dobson(MountStepper &azimuthStepper, MountStepper &altitudeSteppers, Observer &observer);
 
 	// This runs at the very end of the Arduino setup() function and sets the operating mode and initial target
 	void initialize();
 
 	// Calculates the next targets for the steppers, based on the GPS position, current time and target
 	// This does not yet update the stepper motor targets, but stores them in the protected member variable _steppersTarget
-	// It also calls the azAltToRaDec() method with the current stepper position and stores the result
+	// It also converts the current stepper position to Ra/Dec (see azAltToRaDec()) and stores the result
 	void calculateMotorTargets();
 
 	AzAlt<double> raDecToAltAz(RaDecPosition target);
 
 	AzAlt<double> getMotorAngles() {
+		const StepperSnapshot steppers = stepperSnapshot();
 		return {
-			_azimuthStepper.currentPosition() / AZ_STEPS_PER_DEG,
-			_altitudeStepper.currentPosition() / ALT_STEPS_PER_DEG,
+			CoordinatePolicy::toDegrees(steppers.position.azimuth, _azimuthScale),
+			CoordinatePolicy::toDegrees(steppers.position.altitude, _altitudeScale),
 		};
 	}
 
@@ -40,9 +44,23 @@ public:
 	// Calculates the current position in Ra/Dec, which is reported back to Stellarium or other connected tools
 	RaDecPosition azAltToRaDec(AzAlt<double> position);
 
+	// Microseconds until the target moves by one step on either axis, or until the next trajectory has to be queued.
+	// UPDATE_MOTOR_POS_MS while the steppers move to a target or slew (see Mount::scheduleUpdate())
+	unsigned long microsUntilUpdate();
+
 	// Sets the actual motor targets, based on the contents of _steppersTarget
+	// With TRACKING_VELOCITY_FEED_FORWARD or TRACKING_TRAJECTORY the steppers track the target instead, once they are close to it (see track())
 	void move();
 
+#if defined TRACKING_TRAJECTORY || defined SLEW_PLANNER
+	// Steps along the trajectory polynomials. Called by the stepper interrupt
+	#ifdef STEP_GENERATOR
+		unsigned long stepAlongTrajectory(const unsigned long elapsedMicros);
+	#else
+		void stepAlongTrajectory();
+	#endif
+#endif
+
 	// It is set to true at the end of the move() method, if at least one stepper target was changed
 	// It is then reset at the beginning of calculateMotorTargets()
 	bool _didMove = false;
@@ -54,30 +72,124 @@ public:
 
 protected:
 	// Reference to the azimuth stepper
-	AccelStepper &_azimuthStepper;
+	MountStepper &_azimuthStepper;
 	
 	// Reference to the altitude stepper
-	AccelStepper &_altitudeStepper;
+	MountStepper &_altitudeStepper;
 
 	// Reference to the Observer (GPS/Fixed)
 	Observer &_observer;
 
-	// Stores the current local sidereal time
-	// This is written to (and used) by calculateMotorTargets() and just used by azAltToRaDec()
+	// Stores the current local sidereal time (read from the Observer's SiderealClock)
+	// This is written to by updateCoordinateEngine()
 	double _currentLocalSiderealTime;
 
+	// Converts between Ra/Dec and Az/Alt. Its matrix is rebuilt by updateCoordinateEngine() and used by raDecToAltAz() and azAltToRaDec()
+	CoordinateEngine _coordinateEngine;
+
+	// Unit vector of _target and the target it was calculated from
+	CoordinateEngine::Vector _targetVector = { 0., 0., 0. };
+	RaDecPosition _targetVectorSource = { -1., -1. };
+
 	// Target position in degrees
-	AzAlt<double> _targetDegrees;
+	AzAlt<CoordinateEngine::Real> _targetDegrees;
+
+#ifdef TRACKING_VELOCITY_FEED_FORWARD
+	// How fast the target moves at _targetDegrees, in degrees per second. It is written to by calculateMotorTargets()
+	AzAlt<CoordinateEngine::Real> _targetRate = { 0., 0. };
+#endif
+
+#if defined TRACKING_TRAJECTORY || defined SLEW_PLANNER
+	// Trajectories the stepper interrupt follows, copied from the current segment. Only the stepper interrupt uses them
+	Trajectory _azimuthTrajectory;
+	Trajectory _altitudeTrajectory;
+
+	#ifdef STEP_GENERATOR
+		// Microseconds passed since the last whole tick of the trajectories
+		unsigned long _trajectoryElapsed = 0;
+	#else
+		// Direction the steppers were last set to by stepAlongTrajectory() (-1 or 1). 0 means not set yet
+		int8_t _azimuthDirection = 0;
+		int8_t _altitudeDirection = 0;
+	#endif
+#endif
+
+#ifdef TRACKING_TRAJECTORY
+	// The newest queued trajectory segment. targetFromTrajectory() reads the target from its polynomials
+	MotionSegment _trajectorySegment;
+
+	// The target and observer position (ObserverTrigonometry::version) the trajectories were fitted for
+	RaDecPosition _trajectoryTarget = { -1., -1. };
+	unsigned int _trajectoryObserverVersion = 0;
+#endif
+
+#ifdef SLEW_PLANNER
+	// The current slew. Its phases are queued as trajectory segments, as many as the motion queue takes at a time
+	SlewPlanner _slew;
+	bool _slewing = false;
+
+	// micros() at which the slew started, and the number of its phases queued so far (the last one is the end position)
+	unsigned long _slewStartMicros = 0;
+	uint8_t _slewQueuedPhases = 0;
+#endif
+
+	// Conversion between degrees and steps of each axis in the number format of the CoordinatePolicy
+	const CoordinatePolicy::StepScale _azimuthScale;
+	const CoordinatePolicy::StepScale _altitudeScale;
 
-	// The position of the steppers when homing was performed (in steps).
-	AzAlt<long> _steppersHomed;
+	// The position of the steppers when homing or aligning was performed (in steps). The azimuth is where the cables are not wound up (see AZ_CABLE_WRAP_DEG)
+	AzAlt<long> _steppersHomed = { 0, 0 };
 
-	// Current stepper target position for the steppers (in steps). It is written to at the end of calculateMotorTargets()
-	AzAlt<long> _steppersTarget;
+	// setAlignment() could not queue the segment that sets the stepper position to _steppersHomed. move() queues it
+	bool _alignmentPending = false;
 
 	// Target position for the steppers before the last move (in steps). It is written to at the end of move()
 	AzAlt<long> _steppersLastTarget;
 
+	// Updates the LST and the rotation matrix of _coordinateEngine
+	void updateCoordinateEngine();
+
+	// Turns the azimuth steps of an azimuth in [0, 360) into continuous steps on the revolution a GoTo should move to.
+	// altitude is the altitude target in steps, for the slew time estimate
+	long unwrapAzimuth(const long azimuth, const long altitude);
+
+	// Is the azimuth (in continuous steps) within AZ_CABLE_WRAP_DEG of _steppersHomed?
+	bool isWithinCableWrap(const long azimuth);
+
+	// Starts a queued segment. Called by the stepper interrupt, see Mount::startDueSegments()
+	void startSegment(const MotionSegment& segment, const unsigned long lateMicros, const unsigned long elapsedMicros);
+
+	// Tracks the target at speed or along trajectories. Returns false if the steppers should move to _steppersTarget instead
+	bool track();
+
+	// Queues a move of the steppers to position. With SLEW_PLANNER, moves further than TRACKING_MAX_ERROR are slews
+	bool queueMove(const AzAlt<long> position);
+
+#ifdef SLEW_PLANNER
+	// Where the target (now at position, in steps) will be when a slew from from to it arrives
+	AzAlt<long> targetAtArrival(const AzAlt<long> from, const AzAlt<long> position);
+
+	// Plans a slew of both axes and queues its first phases
+	bool startSlew(const AzAlt<long> from, const AzAlt<long> to);
+
+	// Queues the next phases of the slew, as far as the motion queue has room. Returns true until the slew is over
+	bool continueSlew();
+#endif
+
+	// Sets _steppersTarget and _targetDegrees from the trajectories, if they are in use and up to date
+	bool targetFromTrajectory();
+
+#ifdef TRACKING_TRAJECTORY
+	// Do the queued trajectories follow an old target or observer position?
+	bool isTrajectoryStale();
+
+	// Fits the trajectories to the target over TRAJECTORY_WINDOW_MS from startMicros and queues them for the stepper interrupt
+	void startTrajectories(const unsigned long startMicros);
+#endif
+
+	// Seconds until the target position (in steps), moving at rate (in steps per second), reaches the next whole step
+	static double secondsUntilStep(const double position, const double rate);
+
 	// Outputs various debug statements
 	void debugMove(long diffAz, long diffAlt);
 };
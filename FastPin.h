@@ -0,0 +1,170 @@
+#pragma once
+/*
+ * FastPin.h
+ *
+ * Digital output pins with the pin number as a template parameter, e.g. FastPin<AZ_STEP_PIN>::writeHigh().
+ * digitalWrite() looks up the port and bit of the pin in tables and checks for PWM timers on every call.
+ * Here the lookup happens at compile time:
+ *     Arduino Mega: The port and bit come from the table below. Ports A to G are written with a single sbi/cbi instruction.
+ *                   Ports H to L are outside the I/O space, so they are read, modified and written with interrupts disabled
+ *     Arduino Due:  One store to the set or clear register of the PIO controller (PIO_SODR / PIO_CODR), which is atomic.
+ *                   The controller and bit come from the core's pin table, but the index into it is a constant
+ *     Anything else (e.g. the host build): digitalWrite()
+ *
+ * write() remembers the level and only writes to the pin when it changes. It is meant for the main loop.
+ * writeHigh() and writeLow() always write and can be used from interrupts (step pulses)
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+	#define FAST_PIN_AVR_MEGA
+#elif defined(__SAM3X8E__)
+	#define FAST_PIN_SAM
+#endif
+
+#ifdef FAST_PIN_AVR_MEGA
+namespace FastPinMega {
+	// Data space address of the PINx register of ports A to L (there is no port I). DDRx and PORTx follow it
+	constexpr uint16_t pinRegisters[] = {
+		0x20, 0x23, 0x26, 0x29, 0x2C, 0x2F, 0x32, 0x100, 0x103, 0x106, 0x109
+	};
+
+	// Port index (see pinRegisters) and bit of every pin. The port letters are pasted into AVR_PORT_x,
+	// so that Arduino macros like F() do not get in the way
+	enum {
+		AVR_PORT_A, AVR_PORT_B, AVR_PORT_C, AVR_PORT_D, AVR_PORT_E, AVR_PORT_F,
+		AVR_PORT_G, AVR_PORT_H, AVR_PORT_J, AVR_PORT_K, AVR_PORT_L
+	};
+	#define FAST_PIN_PORT_BIT(port, bit) static_cast<uint8_t>(AVR_PORT_##port << 3 | (bit))
+	constexpr uint8_t pins[] = {
+		// 0 - 13
+		FAST_PIN_PORT_BIT(E, 0), FAST_PIN_PORT_BIT(E, 1), FAST_PIN_PORT_BIT(E, 4), FAST_PIN_PORT_BIT(E, 5),
+		FAST_PIN_PORT_BIT(G, 5), FAST_PIN_PORT_BIT(E, 3), FAST_PIN_PORT_BIT(H, 3), FAST_PIN_PORT_BIT(H, 4),
+		FAST_PIN_PORT_BIT(H, 5), FAST_PIN_PORT_BIT(H, 6), FAST_PIN_PORT_BIT(B, 4), FAST_PIN_PORT_BIT(B, 5),
+		FAST_PIN_PORT_BIT(B, 6), FAST_PIN_PORT_BIT(B, 7),
+		// 14 - 21
+		FAST_PIN_PORT_BIT(J, 1), FAST_PIN_PORT_BIT(J, 0), FAST_PIN_PORT_BIT(H, 1), FAST_PIN_PORT_BIT(H, 0),
+		FAST_PIN_PORT_BIT(D, 3), FAST_PIN_PORT_BIT(D, 2), FAST_PIN_PORT_BIT(D, 1), FAST_PIN_PORT_BIT(D, 0),
+		// 22 - 29
+		FAST_PIN_PORT_BIT(A, 0), FAST_PIN_PORT_BIT(A, 1), FAST_PIN_PORT_BIT(A, 2), FAST_PIN_PORT_BIT(A, 3),
+		FAST_PIN_PORT_BIT(A, 4), FAST_PIN_PORT_BIT(A, 5), FAST_PIN_PORT_BIT(A, 6), FAST_PIN_PORT_BIT(A, 7),
+		// 30 - 37
+		FAST_PIN_PORT_BIT(C, 7), FAST_PIN_PORT_BIT(C, 6), FAST_PIN_PORT_BIT(C, 5), FAST_PIN_PORT_BIT(C, 4),
+		FAST_PIN_PORT_BIT(C, 3), FAST_PIN_PORT_BIT(C, 2), FAST_PIN_PORT_BIT(C, 1), FAST_PIN_PORT_BIT(C, 0),
+		// 38 - 41
+		FAST_PIN_PORT_BIT(D, 7), FAST_PIN_PORT_BIT(G, 2), FAST_PIN_PORT_BIT(G, 1), FAST_PIN_PORT_BIT(G, 0),
+		// 42 - 49
+		FAST_PIN_PORT_BIT(L, 7), FAST_PIN_PORT_BIT(L, 6), FAST_PIN_PORT_BIT(L, 5), FAST_PIN_PORT_BIT(L, 4),
+		FAST_PIN_PORT_BIT(L, 3), FAST_PIN_PORT_BIT(L, 2), FAST_PIN_PORT_BIT(L, 1), FAST_PIN_PORT_BIT(L, 0),
+		// 50 - 53
+		FAST_PIN_PORT_BIT(B, 3), FAST_PIN_PORT_BIT(B, 2), FAST_PIN_PORT_BIT(B, 1), FAST_PIN_PORT_BIT(B, 0),
+		// 54 - 61 (A0 - A7)
+		FAST_PIN_PORT_BIT(F, 0), FAST_PIN_PORT_BIT(F, 1), FAST_PIN_PORT_BIT(F, 2), FAST_PIN_PORT_BIT(F, 3),
+		FAST_PIN_PORT_BIT(F, 4), FAST_PIN_PORT_BIT(F, 5), FAST_PIN_PORT_BIT(F, 6), FAST_PIN_PORT_BIT(F, 7),
+		// 62 - 69 (A8 - A15)
+		FAST_PIN_PORT_BIT(K, 0), FAST_PIN_PORT_BIT(K, 1), FAST_PIN_PORT_BIT(K, 2), FAST_PIN_PORT_BIT(K, 3),
+		FAST_PIN_PORT_BIT(K, 4), FAST_PIN_PORT_BIT(K, 5), FAST_PIN_PORT_BIT(K, 6), FAST_PIN_PORT_BIT(K, 7)
+	};
+	#undef FAST_PIN_PORT_BIT
+
+	constexpr uint16_t portRegister(const uint8_t pin) {
+		return pinRegisters[pins[pin] >> 3] + 2;
+	}
+
+	constexpr uint8_t bitMask(const uint8_t pin) {
+		return 1 << (pins[pin] & 7);
+	}
+}
+#endif
+
+
+template<uint8_t Pin>
+class FastPin {
+public:
+	// Makes the pin an output. For setup(), so this simply uses pinMode()
+	static void setOutput() {
+		pinMode(Pin, OUTPUT);
+		_level = UNKNOWN;
+	}
+
+	// Writes the level, unless it already is the level written last time
+	static void write(const bool high) {
+		const uint8_t level = high ? HIGH : LOW;
+		if (level == _level) {
+			return;
+		}
+		_level = level;
+		if (high) {
+			writeHigh();
+		}
+		else {
+			writeLow();
+		}
+	}
+
+	static void writeHigh() {
+	#if defined FAST_PIN_AVR_MEGA
+		static_assert(Pin < sizeof(FastPinMega::pins), "There is no such pin on the Arduino Mega");
+		if (FastPinMega::portRegister(Pin) < 0x40) {
+			port() |= FastPinMega::bitMask(Pin);
+		}
+		else {
+			const uint8_t status = SREG;
+			cli();
+			port() |= FastPinMega::bitMask(Pin);
+			SREG = status;
+		}
+	#elif defined FAST_PIN_SAM
+		g_APinDescription[Pin].pPort->PIO_SODR = g_APinDescription[Pin].ulPin;
+	#else
+		digitalWrite(Pin, HIGH);
+	#endif
+	}
+
+	static void writeLow() {
+	#if defined FAST_PIN_AVR_MEGA
+		static_assert(Pin < sizeof(FastPinMega::pins), "There is no such pin on the Arduino Mega");
+		if (FastPinMega::portRegister(Pin) < 0x40) {
+			port() &= ~FastPinMega::bitMask(Pin);
+		}
+		else {
+			const uint8_t status = SREG;
+			cli();
+			port() &= ~FastPinMega::bitMask(Pin);
+			SREG = status;
+		}
+	#elif defined FAST_PIN_SAM
+		g_APinDescription[Pin].pPort->PIO_CODR = g_APinDescription[Pin].ulPin;
+	#else
+		digitalWrite(Pin, LOW);
+	#endif
+	}
+
+	// Writes the level, without comparing it to the last one
+	static void writeLevel(const bool high) {
+		if (high) {
+			writeHigh();
+		}
+		else {
+			writeLow();
+		}
+	}
+
+protected:
+	// _level before the first write()
+	static const uint8_t UNKNOWN = 0xFF;
+
+	// Level of the last write(). Only write() uses it, so writeHigh() / writeLow() from an interrupt do not touch it
+	static uint8_t _level;
+
+#ifdef FAST_PIN_AVR_MEGA
+	static volatile uint8_t& port() {
+		return *reinterpret_cast<volatile uint8_t*>(FastPinMega::portRegister(Pin));
+	}
+#endif
+};
+
+template<uint8_t Pin>
+uint8_t FastPin<Pin>::_level = FastPin<Pin>::UNKNOWN;
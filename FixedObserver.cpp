@@ -1,4 +1,5 @@
 #include "FixedObserver.h"
+#include "SerialOutput.h"
 
 #include <Time.h>
 
@@ -7,6 +8,7 @@ FixedObserver::FixedObserver(const float altitude, const float latitude, const f
 	// Initialize the position
 	setPosition({ altitude, latitude, longitude });
 	setTime(hour, minute, second, day, month, year);
+	_siderealClock.synchronize();
 }
 
 void FixedObserver::initialize() {
@@ -23,11 +25,11 @@ bool FixedObserver::hasValidPosition() {
 }
 
 void FixedObserver::printDebugInfo() {
-	Serial.println("Fixed position used (GPS_FIXED_POS)");
-	Serial.print("Altitude   ... ");
-	Serial.println(String(altitude(), 6));
-	Serial.print("Latitude   ... ");
-	Serial.println(String(latitude(), 6));
-	Serial.print("Longitude  ... ");
-	Serial.println(String(longitude(), 6));
+	SerialReplies.println("Fixed position used (GPS_FIXED_POS)");
+	SerialReplies.print("Altitude   ... ");
+	SerialReplies.println(String(altitude(), 6));
+	SerialReplies.print("Latitude   ... ");
+	SerialReplies.println(String(latitude(), 6));
+	SerialReplies.print("Longitude  ... ");
+	SerialReplies.println(String(longitude(), 6));
 }
\ No newline at end of file
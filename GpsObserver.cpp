@@ -1,6 +1,7 @@
 #include "./Observer.h"
 #include "./GpsObserver.h"
 #include "./config.h"
+#include "./SerialOutput.h"
 
 #include <FuGPS.h>
 #include <Time.h>
@@ -21,14 +22,9 @@ void GpsObserver::initialize() {
 	// Load stored position and time from the EEPROM
 	//loadFromEEPROM(); // Disabled
 
-	// Wait a little bit so that the module can initialize
-	delay(500);
-
-	// Set up the module
-	_gps.sendCommand(FUGPS_PMTK_SET_NMEA_BAUDRATE_9600);
-	_gps.sendCommand(FUGPS_PMTK_SET_NMEA_UPDATERATE_1HZ);
-	//fuGPS.sendCommand(FUGPS_PMTK_API_SET_NMEA_OUTPUT_DEFAULT);
-	_gps.sendCommand(FUGPS_PMTK_API_SET_NMEA_OUTPUT_RMCGGA);
+	// The module needs a little time to initialize. updatePosition() sets it up once that has passed
+	_initializedMillis = millis();
+	_moduleConfigured = false;
 
 	setPosition({
 		_gps.Altitude,
@@ -38,6 +34,18 @@ void GpsObserver::initialize() {
 }
 
 void GpsObserver::updatePosition() {
+	// Set up the module, once it had GPS_STARTUP_MS to initialize
+	if (!_moduleConfigured) {
+		if (millis() - _initializedMillis < GPS_STARTUP_MS) {
+			return;
+		}
+		_moduleConfigured = true;
+		_gps.sendCommand(FUGPS_PMTK_SET_NMEA_BAUDRATE_9600);
+		_gps.sendCommand(FUGPS_PMTK_SET_NMEA_UPDATERATE_1HZ);
+		//fuGPS.sendCommand(FUGPS_PMTK_API_SET_NMEA_OUTPUT_DEFAULT);
+		_gps.sendCommand(FUGPS_PMTK_API_SET_NMEA_OUTPUT_RMCGGA);
+	}
+
 	// Has the GPS module sent any updates?
 	if (_gps.read()) {
 		// If there are updates, it's connected and running, obviously
@@ -57,6 +65,7 @@ void GpsObserver::updatePosition() {
 			if (!_didSetTimeWithFix) {
 				_didSetTimeWithFix = true;
 				setTime(_gps.Hours - TIMEZONE_CORRECTION_H, _gps.Minutes, _gps.Seconds, _gps.Days, _gps.Months, _gps.Years);
+				_siderealClock.synchronize();
 			}
 
 			#ifdef DEBUG_GPS
@@ -82,6 +91,7 @@ void GpsObserver::updatePosition() {
 			if (!_didSetTimeWithFix && !_didSetTimeWithoutFix && _gps.Satellites > min_satellites) {
 				_didSetTimeWithoutFix = true; // Only set time once
 				setTime(_gps.Hours - TIMEZONE_CORRECTION_H, _gps.Minutes, _gps.Seconds, _gps.Days, _gps.Months, _gps.Years);
+				_siderealClock.synchronize();
 			}
 		}
 
@@ -148,21 +158,21 @@ bool GpsObserver::hasValidPosition() {
 }
 
 void GpsObserver::printDebugInfo() {
-	Serial.println("GPS Status: ");
-	Serial.print("Alive      ... ");
-	Serial.println(_gps.isAlive() ? "Yes" : "No");
-	Serial.print("Fix        ... ");
-	Serial.println((_gps.hasFix() ? "Yes" : "No"));
-	Serial.print("Satellites ... ");
-	Serial.println(String(_gps.Satellites, 6));
-	Serial.print("Acceptable ... ");
-	Serial.println(hasValidPosition() ? "Yes" : "No");
-	Serial.print("Quality    ... ");
-	Serial.println(String(_gps.Quality, 6));
-	Serial.print("Altitude   ... ");
-	Serial.println(String(_gps.Altitude, 6));
-	Serial.print("Latitude   ... ");
-	Serial.println(String(_gps.Latitude, 6));
-	Serial.print("Longitude  ... ");
-	Serial.println(String(_gps.Longitude, 6));
+	SerialReplies.println("GPS Status: ");
+	SerialReplies.print("Alive      ... ");
+	SerialReplies.println(_gps.isAlive() ? "Yes" : "No");
+	SerialReplies.print("Fix        ... ");
+	SerialReplies.println((_gps.hasFix() ? "Yes" : "No"));
+	SerialReplies.print("Satellites ... ");
+	SerialReplies.println(String(_gps.Satellites, 6));
+	SerialReplies.print("Acceptable ... ");
+	SerialReplies.println(hasValidPosition() ? "Yes" : "No");
+	SerialReplies.print("Quality    ... ");
+	SerialReplies.println(String(_gps.Quality, 6));
+	SerialReplies.print("Altitude   ... ");
+	SerialReplies.println(String(_gps.Altitude, 6));
+	SerialReplies.print("Latitude   ... ");
+	SerialReplies.println(String(_gps.Latitude, 6));
+	SerialReplies.print("Longitude  ... ");
+	SerialReplies.println(String(_gps.Longitude, 6));
 }
\ No newline at end of file
@@ -26,5 +26,10 @@ protected:
 	bool _gpsAlive = false;
 	bool _didSetTimeWithoutFix = false;
 	bool _didSetTimeWithFix = false;
+
+	// Time the module gets after initialize() before it is set up. updatePosition() waits for it instead of delay()
+	static const unsigned long GPS_STARTUP_MS = 500;
+	unsigned long _initializedMillis = 0;
+	bool _moduleConfigured = false;
 };
 
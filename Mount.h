@@ -6,7 +6,12 @@
  */
 #pragma once
 
+#include "./config.h"
 #include "./location.h"
+#include "./RingBuffer.h"
+#include "./SeqLock.h"
+#include "./StepGenerator.h"
+#include "./Trajectory.h"
 
 // Type used to store positions in horizontal coordinates (alt/az)
 template<typename T>
@@ -43,6 +48,51 @@ enum Mode {
 	TRACKING
 };
 
+// How the stepper interrupt drives the steppers. See the tracking section in config.h
+enum DriveMode {
+	// run(): Accelerate to the target position of the steppers (moveTo()) and stop there
+	DRIVE_TO_POSITION,
+
+	// runSpeed(): Run at the speed set by the mount (TRACKING_VELOCITY_FEED_FORWARD)
+	DRIVE_AT_SPEED,
+
+	// Mount::stepAlongTrajectory(): Follow the trajectory polynomials of the mount (TRACKING_TRAJECTORY, SLEW_PLANNER)
+	DRIVE_ALONG_TRAJECTORY
+};
+
+// Position of both steppers at the same moment. See Mount::stepperSnapshot()
+struct StepperSnapshot {
+	// Position of the steppers (in steps)
+	AzAlt<long> position;
+
+	// micros() at the stepper interrupt that took the snapshot
+	unsigned long timestamp;
+};
+
+// A movement of both steppers, queued by the main loop and started by the stepper interrupt (see Mount::startDueSegments())
+struct MotionSegment {
+	// micros() at which the stepper interrupt starts this segment. It then runs until the next one starts
+	unsigned long startMicros = 0;
+
+	// How the stepper interrupt drives the steppers during this segment
+	DriveMode mode = DRIVE_TO_POSITION;
+
+	// DRIVE_TO_POSITION: Target position of the steppers (in steps)
+	AzAlt<long> position = { 0, 0 };
+
+	// DRIVE_TO_POSITION: Sets the current position of the steppers to position instead of moving there (aligning)
+	bool setPosition = false;
+
+	// DRIVE_AT_SPEED: Speed of the steppers (in steps per second)
+	AzAlt<float> speed = { 0.f, 0.f };
+
+#if defined TRACKING_TRAJECTORY || defined SLEW_PLANNER
+	// DRIVE_ALONG_TRAJECTORY: Trajectories of the steppers, started (Trajectory::start()) at startMicros
+	Trajectory azimuthTrajectory;
+	Trajectory altitudeTrajectory;
+#endif
+};
+
 class Mount {
 public:
 
@@ -56,17 +106,18 @@ public:
 		DEBUG_PRINTLN(_mode);
 	}
 
-	virtual void initialize();
+	virtual void initialize() = 0;
 
-	virtual void calculateMotorTargets();
+	virtual void calculateMotorTargets() = 0;
 
-	virtual void move();
+	virtual void move() = 0;
 
-	virtual void setAlignment(RaDecPosition alignment);
+	virtual void setAlignment(RaDecPosition alignment) = 0;
 
 
 	void setHomed(const bool value = true) {
 		_isHomed = value;
+		requestUpdate();
 		if (value) {
 			setMode(Mode::TRACKING);
 		}
@@ -92,6 +143,7 @@ public:
 		DEBUG_PRINT("");
 		_lastTarget = _target;
 		_target = target;
+		requestUpdate();
 	}
 
 	RaDecPosition getTarget() {
@@ -102,15 +154,140 @@ public:
 		return _currentPosition;
 	}
 
-	virtual AzAlt<double> getMotorAngles();
+	virtual AzAlt<double> getMotorAngles() = 0;
+
+	// Stepper target position of the last calculateMotorTargets() (in steps)
+	AzAlt<long> getSteppersTarget() {
+		return _steppersTarget;
+	}
+
+	/*
+	 * When calculateMotorTargets() and move() run next. The main loop checks isUpdateDue() and calls scheduleUpdate()
+	 * after each update. Changes that can not wait (a new target, aligning, a new observer position) call requestUpdate()
+	 */
+	bool isUpdateDue() {
+		return _updateRequested || (long)(micros() - _nextUpdateMicros) >= 0;
+	}
+
+	void requestUpdate() {
+		_updateRequested = true;
+	}
+
+	// Sets the next update to microsUntilUpdate() from now, within UPDATE_MOTOR_POS_MIN_MS and UPDATE_MOTOR_POS_MAX_MS
+	void scheduleUpdate() {
+		const unsigned long wait = microsUntilUpdate();
+		_nextUpdateMicros = micros() + constrain(wait, UPDATE_MOTOR_POS_MIN_MS * 1000UL, UPDATE_MOTOR_POS_MAX_MS * 1000UL);
+		_updateRequested = false;
+	}
+
+	// Microseconds after which the last update is outdated. Mounts that can not tell update every UPDATE_MOTOR_POS_MS
+	virtual unsigned long microsUntilUpdate() {
+		return UPDATE_MOTOR_POS_MS * 1000UL;
+	}
+
+	// Tells the stepper interrupt how to drive the steppers
+	DriveMode getDriveMode() {
+		return _driveMode;
+	}
+
+	/*
+	 * Called by the stepper interrupt before it drives the steppers, elapsedMicros after the previous call.
+	 * Starts the newest queued segment whose start time has come, and drops all segments queued before it.
+	 * A segment queued to start right away therefore replaces everything queued so far
+	 */
+	void startDueSegments(const unsigned long elapsedMicros) {
+		const uint8_t queued = _motionQueue.size();
+		if (queued == 0) {
+			return;
+		}
+
+		const unsigned long now = micros();
+		uint8_t due = 0;
+		for (uint8_t i = 0; i < queued; i++) {
+			if ((long)(now - _motionQueue.peek(i).startMicros) >= 0) {
+				due = i + 1;
+			}
+		}
+		if (due == 0) {
+			return;
+		}
+
+		const MotionSegment& segment = _motionQueue.peek(due - 1);
+		startSegment(segment, now - segment.startMicros, elapsedMicros);
+		_driveMode = segment.mode;
+		_motionQueue.pop(due);
+	}
+
+	// Called at the end of the stepper interrupt with the positions of the steppers and the micros() it started at
+	void publishSteppers(const long azimuth, const long altitude, const unsigned long timestamp) {
+		_stepperSnapshot.write({ { azimuth, altitude }, timestamp });
+	}
+
+	// Position of both steppers as of the last stepper interrupt. Both axes are from the same interrupt, and neither
+	// is torn by an interrupt in the middle of reading it. Interrupts stay enabled (see SeqLock.h)
+	StepperSnapshot stepperSnapshot() const {
+		return _stepperSnapshot.read();
+	}
+
+	// Called by the stepper interrupt while the drive mode is DRIVE_ALONG_TRAJECTORY
+	#ifdef STEP_GENERATOR
+		// elapsedMicros after the previous interrupt. Returns the microseconds until the next step is due (see StepGenerator::run())
+		virtual unsigned long stepAlongTrajectory(const unsigned long elapsedMicros) { return NO_STEP_DUE; }
+	#else
+		// Once per tick
+		virtual void stepAlongTrajectory() {}
+	#endif
 
 protected:
+	// Starts the segment in the stepper interrupt. lateMicros is how long ago it should have started,
+	// elapsedMicros is passed on from startDueSegments()
+	virtual void startSegment(const MotionSegment& segment, const unsigned long lateMicros, const unsigned long elapsedMicros) = 0;
+
+	// Queues a segment for the stepper interrupt, without waiting for it. Returns false if the queue is full
+	bool queueSegment(const MotionSegment& segment) {
+		if (!_motionQueue.push(segment)) {
+			return false;
+		}
+		_queuedDriveMode = segment.mode;
+		return true;
+	}
+
+	// Queues a segment that starts right away and replaces all queued segments
+	bool queueSegmentNow(MotionSegment segment) {
+		segment.startMicros = micros();
+		return queueSegment(segment);
+	}
+
+	// Queues a move of the steppers to position (in steps), or sets their current position to it (setPosition). It starts at startMicros
+	bool queuePosition(const AzAlt<long> position, const bool setPosition, const unsigned long startMicros) {
+		MotionSegment segment;
+		segment.startMicros = startMicros;
+		segment.mode = DRIVE_TO_POSITION;
+		segment.position = position;
+		segment.setPosition = setPosition;
+		if (!queueSegment(segment)) {
+			return false;
+		}
+		_queuedPosition = position;
+		return true;
+	}
+
+	// The same, starting right away
+	bool queuePosition(const AzAlt<long> position, const bool setPosition) {
+		return queuePosition(position, setPosition, micros());
+	}
+
 	// Which mode the telescope is curently in. See above for what the constants do
 	Mode _mode = Mode::INITIALIZING;
 
 	ObserverPosition _gpsPosition;
 
 	bool _ignoredMoveLastIteration = false;
+
+	// See isUpdateDue()
+	bool _updateRequested = true;
+	unsigned long _nextUpdateMicros = 0;
+
 	bool _isHomed = false;
 	bool _ignoreMoves = false;
 
@@ -123,5 +300,21 @@ protected:
 	// Current stepper target position for the steppers (in steps). It is written to at the end of calculateMotorTargets()
 	AzAlt<long> _steppersTarget;
 
+	// Read by the stepper interrupt. See getDriveMode()
+	// Only the stepper interrupt writes it (see startDueSegments()). The main loop uses _queuedDriveMode
+	volatile DriveMode _driveMode = DRIVE_TO_POSITION;
+
+	// Drive mode of the newest queued segment
+	DriveMode _queuedDriveMode = DRIVE_TO_POSITION;
+
+	// Position of the newest queued DRIVE_TO_POSITION segment. The steppers have arrived once the snapshot is there
+	AzAlt<long> _queuedPosition = { 0, 0 };
+
+	// Written by the stepper interrupt, see publishSteppers()
+	SeqLock<StepperSnapshot> _stepperSnapshot;
+
+	// Segments from the main loop (the producer) to the stepper interrupt (the consumer)
+	RingBuffer<MotionSegment, MOTION_QUEUE_LENGTH> _motionQueue;
+
 };
 
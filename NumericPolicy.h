@@ -0,0 +1,152 @@
+#pragma once
+/*
+ * NumericPolicy.h
+ *
+ * Number formats for the coordinate pipeline. The CoordinateEngine and the conversion between
+ * degrees and stepper steps are templated on one of these policies. config.h selects one per board
+ * (COORDINATE_NUMERIC_POLICY), because the cost of each format differs a lot between the boards:
+ * On the Arduino Mega double is a 32 bit soft-float, on the Due it is a 64 bit soft-float.
+ * Run dobson_bench from the host build for the speed and accuracy of each policy.
+ *
+ * Every policy provides:
+ *     Real                    The type used for angles and the trig functions
+ *     StepScale               Conversion factors between degrees and steps of one axis (see stepScale())
+ *     sin, cos, atan2, sqrt   Trig functions for Real
+ *     toSteps, toDegrees      Conversion between degrees and steps
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "./TrigTables.h"
+
+
+/*
+ * float for everything. This is what double means on the Mega anyway
+ */
+struct Float32Policy {
+	typedef float Real;
+
+	struct StepScale {
+		float stepsPerDegree;
+		float degreesPerStep;
+	};
+
+	static const char* name() {
+		return "float32";
+	}
+
+	static Real sin(const Real x) { return sinf(x); }
+	static Real cos(const Real x) { return cosf(x); }
+	static Real atan2(const Real y, const Real x) { return atan2f(y, x); }
+	static Real sqrt(const Real x) { return sqrtf(x); }
+
+	static StepScale stepScale(const double stepsPerDegree) {
+		return { static_cast<float>(stepsPerDegree), static_cast<float>(1. / stepsPerDegree) };
+	}
+
+	// Rounds towards zero, like the conversion the mounts always did
+	static long toSteps(const Real degrees, const StepScale& scale) {
+		return static_cast<long>(degrees * scale.stepsPerDegree);
+	}
+
+	// Multiplies with the reciprocal, because a division by a non constant costs several times as much on soft-float
+	static Real toDegrees(const long steps, const StepScale& scale) {
+		return steps * scale.degreesPerStep;
+	}
+};
+
+
+/*
+ * float, with the interpolated lookup tables of TrigTables.h instead of libm's trig functions.
+ * The fastest policy on the Mega. See TrigTables.h for the error of the tables
+ */
+struct LookupTablePolicy : Float32Policy {
+	static const char* name() {
+		return "float32 tables";
+	}
+
+	static Real sin(const Real x) { return tableSin(x); }
+	static Real cos(const Real x) { return tableCos(x); }
+	static Real atan2(const Real y, const Real x) { return tableAtan2(y, x); }
+};
+
+
+/*
+ * double for everything. On the Due this is the most precise and slowest policy
+ */
+struct Float64Policy {
+	typedef double Real;
+
+	struct StepScale {
+		double stepsPerDegree;
+		double degreesPerStep;
+	};
+
+	static const char* name() {
+		return "float64";
+	}
+
+	static Real sin(const Real x) { return ::sin(x); }
+	static Real cos(const Real x) { return ::cos(x); }
+	static Real atan2(const Real y, const Real x) { return ::atan2(y, x); }
+	static Real sqrt(const Real x) { return ::sqrt(x); }
+
+	static StepScale stepScale(const double stepsPerDegree) {
+		return { stepsPerDegree, 1. / stepsPerDegree };
+	}
+
+	static long toSteps(const Real degrees, const StepScale& scale) {
+		return static_cast<long>(degrees * scale.stepsPerDegree);
+	}
+
+	static Real toDegrees(const long steps, const StepScale& scale) {
+		return steps * scale.degreesPerStep;
+	}
+};
+
+
+/*
+ * float for the trig functions, fixed point for the step domain.
+ * Degrees are converted to Q11.20 (+-2048 degrees) and multiplied with the steps per degree in
+ * Q16.16 (up to 32767 steps per degree) using a 64 bit integer product. This is a single
+ * instruction on the Due's Cortex-M3 and more precise than the float multiplication.
+ * Unlike the other policies, toSteps() rounds towards negative infinity.
+ */
+struct FixedPointPolicy {
+	typedef float Real;
+
+	static const int ANGLE_FRACTION_BITS = 20;
+	static const int SCALE_FRACTION_BITS = 16;
+
+	struct StepScale {
+		int32_t stepsPerDegree; // Q16.16
+		float degreesPerStep;
+	};
+
+	static const char* name() {
+		return "fixed Q11.20";
+	}
+
+	static Real sin(const Real x) { return sinf(x); }
+	static Real cos(const Real x) { return cosf(x); }
+	static Real atan2(const Real y, const Real x) { return atan2f(y, x); }
+	static Real sqrt(const Real x) { return sqrtf(x); }
+
+	static StepScale stepScale(const double stepsPerDegree) {
+		return {
+			static_cast<int32_t>(stepsPerDegree * (1L << SCALE_FRACTION_BITS) + 0.5),
+			static_cast<float>(1. / stepsPerDegree)
+		};
+	}
+
+	static long toSteps(const Real degrees, const StepScale& scale) {
+		// Multiplying with a power of two only changes the exponent of the float
+		const int32_t angle = static_cast<int32_t>(degrees * static_cast<float>(1L << ANGLE_FRACTION_BITS));
+		return static_cast<long>((static_cast<int64_t>(angle) * scale.stepsPerDegree) >> (ANGLE_FRACTION_BITS + SCALE_FRACTION_BITS));
+	}
+
+	static Real toDegrees(const long steps, const StepScale& scale) {
+		return steps * scale.degreesPerStep;
+	}
+};
@@ -0,0 +1,21 @@
+#include <Arduino.h>
+
+#include "./Observer.h"
+
+
+void Observer::setPosition(ObserverPosition position) {
+	// The GPS module reports the same position over and over again. Only recalculate when it actually moved
+	const bool changed = _trigonometry.version == 0
+		|| position.latitude != _position.latitude
+		|| position.longitude != _position.longitude;
+
+	_position = position;
+
+	if (changed) {
+		_trigonometry.latitudeRadians = radians(position.latitude);
+		_trigonometry.longitudeRadians = radians(position.longitude);
+		_trigonometry.sinLatitude = sin(_trigonometry.latitudeRadians);
+		_trigonometry.cosLatitude = cos(_trigonometry.latitudeRadians);
+		_trigonometry.version++;
+	}
+}
@@ -1,6 +1,19 @@
 #pragma once
 
 #include "./location.h"
+#include "./SiderealClock.h"
+
+// Trigonometric values of the observer position that the mounts need for every coordinate conversion.
+// They only change when the position changes, so Observer keeps them precomputed
+struct ObserverTrigonometry {
+	double sinLatitude;
+	double cosLatitude;
+	double latitudeRadians;
+	double longitudeRadians;
+
+	// Incremented every time the values change. Users can compare it to find out whether values derived from these are stale
+	unsigned int version;
+};
 
 /*
  * This is the base class for GpsPositionProvider and MockPositionProvider which are used
@@ -8,17 +21,16 @@
  */
 class Observer {
 public:
-	virtual void initialize();
+	virtual void initialize() = 0;
 	
-	virtual void updatePosition();
+	virtual void updatePosition() = 0;
 	
-	virtual bool hasValidPosition();
+	virtual bool hasValidPosition() = 0;
 
-	virtual void printDebugInfo();
+	virtual void printDebugInfo() = 0;
 
-	void setPosition(ObserverPosition position) {
-		_position = position;
-	}
+	// Sets the position and updates the precomputed trigonometry, if latitude or longitude changed
+	void setPosition(ObserverPosition position);
 
 	ObserverPosition getPosition() {
 		return _position;
@@ -36,6 +48,21 @@ public:
 		return _position.longitude;
 	}
 
+	// Precomputed trigonometric values of the current position. See setPosition()
+	const ObserverTrigonometry& trigonometry() {
+		return _trigonometry;
+	}
+
+	// The current local sidereal time at the observer's longitude in degrees
+	double localSiderealTime() {
+		return _siderealClock.localSiderealTime(_position.longitude);
+	}
+
 protected:
 	ObserverPosition _position;
+
+	ObserverTrigonometry _trigonometry = { 0., 1., 0., 0., 0 };
+
+	// Implementations must call _siderealClock.synchronize() every time they set the time
+	SiderealClock _siderealClock;
 };
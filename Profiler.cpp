@@ -0,0 +1,131 @@
+#include <Arduino.h>
+
+#include "./Profiler.h"
+
+Scheduler* Profiler::_scheduler = nullptr;
+LatencyHistogram Profiler::_loop = {};
+LatencyHistogram Profiler::_tick = {};
+LatencyHistogram Profiler::_jitter = {};
+unsigned long Profiler::_lateTicks = 0;
+unsigned long Profiler::_loopPeak = 0;
+unsigned long Profiler::_tickPeak = 0;
+unsigned long Profiler::_previousTickMicros = 0;
+bool Profiler::_hasPreviousTick = false;
+
+
+void LatencyHistogram::print(Print& out, const char* name) const {
+	out.print(name);
+	out.print(" max=");
+	out.print(worst);
+	out.print("us");
+	for (uint8_t i = 0; i < BUCKETS; i++) {
+		if (counts[i] == 0) {
+			continue;
+		}
+		out.print(' ');
+		if (i == BUCKETS - 1) {
+			out.print('>');
+			out.print((1UL << i) - 1);
+		}
+		else {
+			out.print('<');
+			out.print(2UL << i);
+		}
+		out.print(':');
+		out.print(counts[i]);
+	}
+	out.println();
+}
+
+
+void Profiler::setScheduler(Scheduler& scheduler) {
+	_scheduler = &scheduler;
+}
+
+
+void Profiler::recordLoop(const unsigned long micros) {
+	_loop.record(micros);
+	if (micros > _loopPeak) {
+		_loopPeak = micros;
+	}
+}
+
+
+void Profiler::recordTick(const unsigned long startMicros, const unsigned long scheduledMicros, const unsigned long durationMicros) {
+	_tick.record(durationMicros);
+	if (durationMicros > _tickPeak) {
+		_tickPeak = durationMicros;
+	}
+
+	if (_hasPreviousTick) {
+		const long late = static_cast<long>((startMicros - _previousTickMicros) - scheduledMicros);
+		_jitter.record(late < 0 ? -late : late);
+		if (late > static_cast<long>(LATE_TICK_MICROS)) {
+			_lateTicks++;
+		}
+	}
+	_previousTickMicros = startMicros;
+	_hasPreviousTick = true;
+}
+
+
+void Profiler::print(Print& out) {
+	// Copy what the stepper interrupt writes, so that the lines are consistent and the interrupt is only stopped briefly
+	noInterrupts();
+	const LatencyHistogram tick = _tick;
+	const LatencyHistogram jitter = _jitter;
+	const unsigned long lateTicks = _lateTicks;
+	interrupts();
+
+	_loop.print(out, "loop");
+	tick.print(out, "isr");
+	jitter.print(out, "jitter");
+	out.print("late ");
+	out.print(lateTicks);
+	out.print(" (>");
+	out.print(LATE_TICK_MICROS);
+	out.println("us)");
+
+	if (_scheduler == nullptr) {
+		return;
+	}
+	for (uint8_t i = 0; i < _scheduler->taskCount(); i++) {
+		const SchedulerTask& task = _scheduler->task(i);
+		out.print("task ");
+		out.print(task.name);
+		out.print(" runs=");
+		out.print(task.runs);
+		out.print(" busy=");
+		out.print(task.busyMicros);
+		out.print("us max=");
+		out.print(task.worstMicros);
+		out.print("us overruns=");
+		out.println(task.overruns);
+	}
+}
+
+
+void Profiler::takePeaks(unsigned long& loopMicros, unsigned long& tickMicros) {
+	loopMicros = _loopPeak;
+	_loopPeak = 0;
+
+	noInterrupts();
+	tickMicros = _tickPeak;
+	_tickPeak = 0;
+	interrupts();
+}
+
+
+void Profiler::reset() {
+	_loop.reset();
+
+	noInterrupts();
+	_tick.reset();
+	_jitter.reset();
+	_lateTicks = 0;
+	interrupts();
+
+	if (_scheduler != nullptr) {
+		_scheduler->resetStatistics();
+	}
+}
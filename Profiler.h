@@ -0,0 +1,106 @@
+#pragma once
+/*
+ * Profiler.h
+ *
+ * Timing counters that are always compiled in, so that field units can be profiled without a debug build.
+ * :PERF# prints them, :PERFRST# sets them to 0 (see conversion.cpp)
+ *
+ *     loop     Duration of each loop() iteration, measured around Scheduler::runNext()
+ *     isr      Duration of each stepper interrupt
+ *     jitter   How far each stepper interrupt started from the time it was scheduled for
+ *     tasks    Runs, total and longest run time and overruns of each scheduler task (see Scheduler.h)
+ *     late     Stepper interrupts that started more than LATE_TICK_MICROS after they were due. A step that was due in such
+ *              an interrupt was made late by at least as much
+ *
+ * The durations are collected in log2 histograms (see LatencyHistogram), which take the same RAM however long the
+ * unit runs. Recording a value is a few shifts and one increment, so it can be done in the stepper interrupt
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "./config.h"
+#include "./Scheduler.h"
+
+/*
+ * Histogram of durations in microseconds. Bucket 0 counts durations of 0 and 1 microseconds, bucket n those of
+ * 2^n up to 2^(n + 1) - 1 microseconds, the last bucket everything longer
+ */
+struct LatencyHistogram {
+	static const uint8_t BUCKETS = 16;
+
+	unsigned long counts[BUCKETS];
+
+	// Longest duration recorded
+	unsigned long worst;
+
+	void record(unsigned long micros) {
+		if (micros > worst) {
+			worst = micros;
+		}
+		uint8_t bucket = 0;
+		while (micros > 1 && bucket < BUCKETS - 1) {
+			micros >>= 1;
+			bucket++;
+		}
+		counts[bucket]++;
+	}
+
+	void reset() {
+		for (uint8_t i = 0; i < BUCKETS; i++) {
+			counts[i] = 0;
+		}
+		worst = 0;
+	}
+
+	// Prints one line: the name, the longest duration and all buckets that are not empty as <upper bound>:<count>
+	void print(Print& out, const char* name) const;
+};
+
+
+class Profiler {
+public:
+	// The scheduler whose task statistics :PERF# prints and :PERFRST# resets
+	static void setScheduler(Scheduler& scheduler);
+
+	// Called by loop() with the duration of one iteration
+	static void recordLoop(const unsigned long micros);
+
+	/*
+	 * Called at the end of every stepper interrupt
+	 *     startMicros     micros() at the beginning of the interrupt
+	 *     scheduledMicros Time from the previous interrupt to this one it was scheduled for
+	 *     durationMicros  How long the interrupt took
+	 */
+	static void recordTick(const unsigned long startMicros, const unsigned long scheduledMicros, const unsigned long durationMicros);
+
+	// Prints all counters
+	static void print(Print& out);
+
+	// Sets all counters to 0
+	static void reset();
+
+	// Longest loop iteration and stepper interrupt since the previous call (for the telemetry frames, see Telemetry.h)
+	static void takePeaks(unsigned long& loopMicros, unsigned long& tickMicros);
+
+	// Delay after which a stepper interrupt counts as late
+#ifdef STEP_GENERATOR
+	static const unsigned long LATE_TICK_MICROS = STEP_TIMER_MIN_MICROS;
+#else
+	static const unsigned long LATE_TICK_MICROS = STEPPER_INTERRUPT_FREQ;
+#endif
+
+protected:
+	static Scheduler* _scheduler;
+
+	static LatencyHistogram _loop;
+	static unsigned long _loopPeak;
+
+	// Written by the stepper interrupt. print() and reset() stop it while they access these
+	static LatencyHistogram _tick;
+	static LatencyHistogram _jitter;
+	static unsigned long _lateTicks;
+	static unsigned long _tickPeak;
+	static unsigned long _previousTickMicros;
+	static bool _hasPreviousTick;
+};
@@ -0,0 +1,65 @@
+#pragma once
+/*
+ * RingBuffer.h
+ *
+ * Lock-free queue between one producer and one consumer, e.g. the main loop and the stepper interrupt.
+ * Only the producer writes _head and only the consumer writes _tail. Both are single bytes, which even the Mega
+ * reads and writes atomically, so neither side ever disables interrupts or waits for the other.
+ * An element is completely written before _head makes it visible, and completely read before _tail releases it.
+ *
+ * Capacity must be a power of two of at most 128, so that the free running indices can simply be masked
+ */
+
+#include <stdint.h>
+
+#include "./macros.h"
+
+template<typename T, uint8_t Capacity>
+class RingBuffer {
+	static_assert(Capacity > 0 && Capacity <= 128 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two of at most 128");
+
+public:
+	// Producer: Appends a copy of element. Returns false (and drops it) if the buffer is full
+	bool push(const T& element) {
+		const uint8_t head = _head;
+		if (static_cast<uint8_t>(head - _tail) >= Capacity) {
+			return false;
+		}
+		_elements[head & (Capacity - 1)] = element;
+		COMPILER_BARRIER();
+		_head = head + 1;
+		return true;
+	}
+
+	// Number of queued elements. Either side can call this. The result is only a lower bound for
+	// the consumer and an upper bound for the producer, as the other side may change it at any time
+	uint8_t size() const {
+		return static_cast<uint8_t>(_head - _tail);
+	}
+
+	bool isEmpty() const {
+		return _head == _tail;
+	}
+
+	bool isFull() const {
+		return size() >= Capacity;
+	}
+
+	// Consumer: The element at index (0 is the oldest). index must be less than size()
+	T& peek(const uint8_t index = 0) {
+		return _elements[static_cast<uint8_t>(_tail + index) & (Capacity - 1)];
+	}
+
+	// Consumer: Releases the count oldest elements. count must not be more than size()
+	void pop(const uint8_t count = 1) {
+		COMPILER_BARRIER();
+		_tail = _tail + count;
+	}
+
+protected:
+	T _elements[Capacity];
+
+	// Free running indices of the next element to write and to read
+	volatile uint8_t _head = 0;
+	volatile uint8_t _tail = 0;
+};
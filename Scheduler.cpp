@@ -0,0 +1,74 @@
+#include <Arduino.h>
+
+#include "./Scheduler.h"
+
+void Scheduler::start() {
+	const unsigned long now = micros();
+	for (uint8_t i = 0; i < _count; i++) {
+		_tasks[i].releaseMicros = now;
+		_tasks[i].overrunMicros = now + _tasks[i].deadlineMicros;
+	}
+}
+
+
+bool Scheduler::runNext() {
+	const unsigned long now = micros();
+
+	SchedulerTask* next = nullptr;
+	for (uint8_t i = 0; i < _count; i++) {
+		SchedulerTask& task = _tasks[i];
+		if ((long)(now - task.releaseMicros) < 0) {
+			continue;
+		}
+		// Of equal priorities, the task released first. Tasks with period 0 are released when they finish, so they take turns
+		if (next == nullptr || task.priority > next->priority
+			|| (task.priority == next->priority && (long)(task.releaseMicros - next->releaseMicros) < 0)) {
+			next = &task;
+		}
+	}
+	if (next == nullptr) {
+		return false;
+	}
+
+	// Count the due tasks that missed a deadline, including the ones that have to wait for next
+	for (uint8_t i = 0; i < _count; i++) {
+		SchedulerTask& task = _tasks[i];
+		if ((long)(now - task.releaseMicros) >= 0 && (long)(now - task.overrunMicros) > 0) {
+			task.overruns++;
+			task.overrunMicros += task.deadlineMicros;
+		}
+	}
+
+	next->run();
+
+	const unsigned long end = micros();
+	const unsigned long duration = end - now;
+	next->runs++;
+	next->busyMicros += duration;
+	if (duration > next->worstMicros) {
+		next->worstMicros = duration;
+	}
+
+	if (next->periodMicros == 0) {
+		next->releaseMicros = end;
+	}
+	else {
+		next->releaseMicros += next->periodMicros;
+		if ((long)(now - next->releaseMicros) >= 0) {
+			// A whole period late. Skip the missed releases
+			next->releaseMicros = now + next->periodMicros;
+		}
+	}
+	next->overrunMicros = next->releaseMicros + next->deadlineMicros;
+	return true;
+}
+
+
+void Scheduler::resetStatistics() {
+	for (uint8_t i = 0; i < _count; i++) {
+		_tasks[i].overruns = 0;
+		_tasks[i].runs = 0;
+		_tasks[i].busyMicros = 0;
+		_tasks[i].worstMicros = 0;
+	}
+}
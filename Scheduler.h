@@ -0,0 +1,73 @@
+#pragma once
+/*
+ * Scheduler.h
+ *
+ * Cooperative scheduler for the tasks of loop(). The tasks are a static table (see Tasks.cpp). Each has
+ *     period    Microseconds from one release of the task to the next. 0 releases it again as soon as it has run
+ *     deadline  Microseconds after its release by which the task should have started
+ *     priority  When several tasks are due, the one with the highest priority runs first
+ * runNext() runs at most one task per call: the due task with the highest priority, and of those the one that was released
+ * first. A task with period 0 is released again when it has run, so the tasks of one priority take turns (round robin).
+ * A task that takes long (e.g. a burst of serial traffic) therefore delays a more important one by at most one run.
+ *
+ * A task that is still waiting at its deadline counts as an overrun, and so does every further deadline interval it waits.
+ * This is counted while the task is passed over for others too, so a task that never gets to run shows up in :PERF#.
+ * A periodic task that is more than a period late skips the releases it missed, instead of running several times in a
+ * row to catch up
+ *
+ * The scheduler also counts the runs of each task and how long they took. :PERF# prints these (see Profiler.h)
+ */
+
+#include <stdint.h>
+
+struct SchedulerTask {
+	// Name for debug outputs
+	const char* name;
+
+	// Runs the task once. It must return quickly, the scheduler can not interrupt it
+	void (*run)();
+
+	unsigned long periodMicros;
+	unsigned long deadlineMicros;
+	uint8_t priority;
+
+	// micros() at which the task is due next. Written by the scheduler
+	unsigned long releaseMicros;
+
+	// Number of deadlines the task missed (see above)
+	unsigned long overruns;
+
+	// Number of runs, their total duration and the longest one in microseconds
+	unsigned long runs;
+	unsigned long busyMicros;
+	unsigned long worstMicros;
+
+	// micros() at which the task, if it is still waiting, counts the next overrun. Written by the scheduler
+	unsigned long overrunMicros;
+};
+
+class Scheduler {
+public:
+	Scheduler(SchedulerTask* tasks, const uint8_t count) : _tasks(tasks), _count(count) {}
+
+	// Releases all tasks now
+	void start();
+
+	// Runs the most urgent due task. Returns false if no task was due
+	bool runNext();
+
+	uint8_t taskCount() const {
+		return _count;
+	}
+
+	const SchedulerTask& task(const uint8_t index) const {
+		return _tasks[index];
+	}
+
+	// Sets the overrun, run and duration counters to 0
+	void resetStatistics();
+
+protected:
+	SchedulerTask* _tasks;
+	const uint8_t _count;
+};
@@ -0,0 +1,47 @@
+#pragma once
+/*
+ * SeqLock.h
+ *
+ * A value written by an interrupt and read by the main loop, without disabling interrupts.
+ * The writer makes the sequence number odd while it writes and even again afterwards. The reader copies the value
+ * and starts over if the sequence number was odd or has changed in the meantime. The copy is then consistent,
+ * even for values the Mega can not read in one instruction (anything longer than a byte).
+ *
+ * There must be only one writer, and it must not be interrupted by the reader (which an interrupt never is)
+ */
+
+#include <stdint.h>
+
+#include "./macros.h"
+
+template<typename T>
+class SeqLock {
+public:
+	// Writer. Called by the interrupt
+	void write(const T& value) {
+		_sequence = _sequence + 1;
+		COMPILER_BARRIER();
+		_value = value;
+		COMPILER_BARRIER();
+		_sequence = _sequence + 1;
+	}
+
+	// Reader. Usually takes one try. It only takes more if the interrupt wrote a new value during the copy
+	T read() const {
+		T value;
+		uint8_t sequence;
+		do {
+			sequence = _sequence;
+			COMPILER_BARRIER();
+			value = _value;
+			COMPILER_BARRIER();
+		} while ((sequence & 1) != 0 || sequence != _sequence);
+		return value;
+	}
+
+protected:
+	T _value = T();
+
+	// Odd while the writer is writing. A single byte, so reading it is atomic on the Mega
+	volatile uint8_t _sequence = 0;
+};
@@ -0,0 +1,178 @@
+#include <Arduino.h>
+
+#include "./SerialOutput.h"
+
+static_assert(SERIAL_REPLY_BUFFER_SIZE > 0 && SERIAL_REPLY_BUFFER_SIZE <= 32768 && (SERIAL_REPLY_BUFFER_SIZE & (SERIAL_REPLY_BUFFER_SIZE - 1)) == 0, "SERIAL_REPLY_BUFFER_SIZE must be a power of two of at most 32768");
+static_assert(SERIAL_DEBUG_BUFFER_SIZE > 0 && SERIAL_DEBUG_BUFFER_SIZE <= 32768 && (SERIAL_DEBUG_BUFFER_SIZE & (SERIAL_DEBUG_BUFFER_SIZE - 1)) == 0, "SERIAL_DEBUG_BUFFER_SIZE must be a power of two of at most 32768");
+
+static uint8_t replyBuffer[SERIAL_REPLY_BUFFER_SIZE];
+static uint8_t debugBuffer[SERIAL_DEBUG_BUFFER_SIZE];
+
+OutputChannel SerialReplies(replyBuffer, SERIAL_REPLY_BUFFER_SIZE, OutputChannel::WAIT);
+OutputChannel SerialDebug(debugBuffer, SERIAL_DEBUG_BUFFER_SIZE, OutputChannel::DROP_LINE);
+
+bool SerialOutput::_buffered = false;
+bool SerialOutput::_debugPaused = false;
+
+
+OutputChannel::OutputChannel(uint8_t* buffer, const uint16_t size, const Overflow overflow) :
+	_buffer(buffer),
+	_size(size),
+	_overflow(overflow),
+	_head(0),
+	_committed(0),
+	_tail(0),
+	_dropping(false),
+	_waits(0),
+	_droppedBytes(0),
+	_droppedLines(0),
+	_unreportedLines(0) {
+}
+
+
+size_t OutputChannel::write(uint8_t value) {
+	if (!SerialOutput::isBuffered()) {
+		return Serial.write(value);
+	}
+
+	if (_overflow == WAIT) {
+		if (freeSpace() == 0) {
+			// Serial.write() waits until the hardware TX buffer has room
+			_waits++;
+			Serial.write(_buffer[_tail & (_size - 1)]);
+			_tail++;
+		}
+		append(value);
+		_committed = _head;
+		return 1;
+	}
+
+	// DROP_LINE. Dropped bytes count as written, as Print stops printing a text at the first byte that was not
+	if (_dropping) {
+		_droppedBytes++;
+		if (value == '\n') {
+			_dropping = false;
+		}
+		return 1;
+	}
+
+	if (_head == _committed && _unreportedLines > 0) {
+		reportDroppedLines();
+	}
+
+	if (freeSpace() == 0) {
+		// Drop the beginning of the line that is already buffered as well
+		_droppedBytes += static_cast<uint16_t>(_head - _committed) + 1;
+		_droppedLines++;
+		_unreportedLines++;
+		_head = _committed;
+		_dropping = value != '\n';
+		return 1;
+	}
+
+	append(value);
+	if (value == '\n') {
+		_committed = _head;
+	}
+	return 1;
+}
+
+
+void OutputChannel::reportDroppedLines() {
+	// Digits of the count, last digit first
+	char digits[10];
+	uint8_t digitCount = 0;
+	unsigned long count = _unreportedLines;
+	do {
+		digits[digitCount++] = '0' + count % 10;
+		count /= 10;
+	} while (count > 0);
+
+	static const char text[] = " debug lines dropped)\r\n";
+	if (freeSpace() < 1 + digitCount + sizeof(text) - 1) {
+		return;
+	}
+
+	append('(');
+	while (digitCount > 0) {
+		append(digits[--digitCount]);
+	}
+	for (const char* c = text; *c != '\0'; c++) {
+		append(*c);
+	}
+	_committed = _head;
+	_unreportedLines = 0;
+}
+
+
+uint16_t OutputChannel::send(const uint16_t count) {
+	uint16_t sent = 0;
+	while (sent < count && pending() > 0) {
+		// The pending bytes may wrap around the end of the buffer, so they are written in up to two pieces
+		const uint16_t start = _tail & (_size - 1);
+		uint16_t length = pending();
+		if (length > _size - start) {
+			length = _size - start;
+		}
+		if (length > count - sent) {
+			length = count - sent;
+		}
+		Serial.write(_buffer + start, length);
+		_tail += length;
+		sent += length;
+	}
+	return sent;
+}
+
+
+void OutputChannel::resetStatistics() {
+	_waits = 0;
+	_droppedBytes = 0;
+	_droppedLines = 0;
+}
+
+
+void SerialOutput::setBuffered(const bool buffered) {
+	if (!buffered) {
+		// Whatever is still buffered goes out first, even if that means waiting for the port
+		SerialReplies.send(SerialReplies.pending());
+		SerialDebug.send(SerialDebug.pending());
+	}
+	_buffered = buffered;
+}
+
+
+void SerialOutput::setDebugPaused(const bool paused) {
+	_debugPaused = paused;
+}
+
+
+void SerialOutput::flush() {
+	const int available = Serial.availableForWrite();
+	if (available <= 0) {
+		return;
+	}
+
+	const uint16_t room = static_cast<uint16_t>(available);
+	const uint16_t sent = SerialReplies.send(room);
+	if (SerialReplies.pending() == 0 && !_debugPaused) {
+		SerialDebug.send(room - sent);
+	}
+}
+
+
+void SerialOutput::printStatistics(Print& out) {
+	out.print("output reply_waits=");
+	out.print(SerialReplies.waits());
+	out.print(" debug_dropped=");
+	out.print(SerialDebug.droppedBytes());
+	out.print("B/");
+	out.print(SerialDebug.droppedLines());
+	out.println(" lines");
+}
+
+
+void SerialOutput::resetStatistics() {
+	SerialReplies.resetStatistics();
+	SerialDebug.resetStatistics();
+}
@@ -0,0 +1,125 @@
+#pragma once
+/*
+ * SerialOutput.h
+ *
+ * Buffered output to the Stellarium / console port (Serial). Printing copies the text into a RAM buffer, and
+ * SerialOutput::flush(), which the serial task calls every time it runs, moves as much of it into the hardware
+ * TX buffer as fits without waiting. So printing does not stop loop() until the serial line has sent the text.
+ * The output goes through one of two channels:
+ *
+ *     SerialReplies  Answers to commands (:GR#, :GD#, :HLP#, ...). Sent before any debug output, so debug messages do not
+ *                    delay the replies Stellarium waits for. Never dropped: If its buffer is full, printing waits until
+ *                    the port takes the oldest byte
+ *     SerialDebug    The DEBUG_PRINT* messages (see config.h). Only sent while no replies are waiting, and only complete
+ *                    lines. A line that does not fit into the buffer any more is dropped as a whole. Consecutive dropped
+ *                    lines are reported with one "(N debug lines dropped)" line once there is room again
+ *
+ * Until setBuffered(true) is called at the end of setup(), both channels write straight through to Serial, so that
+ * no start up messages are lost. :PERF# prints how often replies had to wait and how much debug output was dropped
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "./config.h"
+
+
+class OutputChannel : public Print {
+public:
+	// What happens to text that does not fit into the buffer
+	enum Overflow {
+		WAIT,      // Wait until the port takes the oldest byte
+		DROP_LINE  // Drop the whole line
+	};
+
+	// size must be a power of two of at most 32768
+	OutputChannel(uint8_t* buffer, const uint16_t size, const Overflow overflow);
+
+	size_t write(uint8_t value) override;
+	using Print::write;
+
+	// Number of buffered bytes that can be sent. DROP_LINE channels hold back the line that is not complete yet
+	uint16_t pending() const {
+		return static_cast<uint16_t>(_committed - _tail);
+	}
+
+	// Writes up to count of the pending bytes to Serial. Returns the number of bytes written
+	uint16_t send(const uint16_t count);
+
+	// Times a WAIT channel had to wait for the port
+	unsigned long waits() const {
+		return _waits;
+	}
+
+	// Bytes and lines a DROP_LINE channel dropped
+	unsigned long droppedBytes() const {
+		return _droppedBytes;
+	}
+
+	unsigned long droppedLines() const {
+		return _droppedLines;
+	}
+
+	void resetStatistics();
+
+protected:
+	uint16_t freeSpace() const {
+		return static_cast<uint16_t>(_size - (_head - _tail));
+	}
+
+	void append(const uint8_t value) {
+		_buffer[_head & (_size - 1)] = value;
+		_head++;
+	}
+
+	// Appends the "(N debug lines dropped)" line, if it fits
+	void reportDroppedLines();
+
+	uint8_t* _buffer;
+	const uint16_t _size;
+	const Overflow _overflow;
+
+	// Free running indices. _committed is the end of the last complete line (DROP_LINE) or equal to _head (WAIT)
+	uint16_t _head;
+	uint16_t _committed;
+	uint16_t _tail;
+
+	// The current line was dropped, so the rest of it is dropped too
+	bool _dropping;
+
+	unsigned long _waits;
+	unsigned long _droppedBytes;
+	unsigned long _droppedLines;
+	unsigned long _unreportedLines;
+};
+
+
+class SerialOutput {
+public:
+	// Switches between buffered output (see above) and writing straight through to Serial
+	static void setBuffered(const bool buffered);
+
+	static bool isBuffered() {
+		return _buffered;
+	}
+
+	// Moves as many pending bytes into the hardware TX buffer as fit without waiting. Replies go first
+	static void flush();
+
+	// Keeps flush() from sending debug messages, e.g. while the telemetry stream runs (see Telemetry.h).
+	// They stay in their buffer meanwhile, and lines that do not fit any more are dropped
+	static void setDebugPaused(const bool paused);
+
+	// Prints one line with the counters of both channels
+	static void printStatistics(Print& out);
+
+	static void resetStatistics();
+
+protected:
+	static bool _buffered;
+	static bool _debugPaused;
+};
+
+
+extern OutputChannel SerialReplies;
+extern OutputChannel SerialDebug;
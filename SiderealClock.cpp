@@ -0,0 +1,65 @@
+#include <Arduino.h>
+
+#include "./location.h"
+#include "./SiderealClock.h"
+
+// How far the sidereal time advances per microsecond, in degrees
+const double SIDEREAL_DEGREES_PER_MICROSECOND = SIDEREAL_DEGREES_PER_SECOND / 1000000.;
+
+// How far the sidereal time advances per solar day beyond a full revolution, in degrees.
+// Splitting elapsed time into days and seconds of the day keeps the products small enough for a 32 bit double
+const double SIDEREAL_DEGREES_PER_DAY_EXCESS = 0.98564736629;
+
+
+void SiderealClock::synchronize() {
+	_anchorSiderealTime = get_local_sidereal_time(0.);
+	_secondMicros = micros();
+	_elapsedSeconds = 0;
+	_secondsSiderealTime = _anchorSiderealTime;
+	_synchronized = true;
+}
+
+
+void SiderealClock::advanceSeconds(const unsigned long elapsedMicros) {
+	const unsigned long seconds = elapsedMicros / 1000000UL;
+	_secondMicros += seconds * 1000000UL;
+	_elapsedSeconds += seconds;
+
+	// Always calculated from the anchor, so that rounding errors do not add up
+	const unsigned long days = _elapsedSeconds / 86400UL;
+	const unsigned long secondOfDay = _elapsedSeconds % 86400UL;
+	double gst = _anchorSiderealTime
+		+ fmod(days * SIDEREAL_DEGREES_PER_DAY_EXCESS, 360.)
+		+ secondOfDay * SIDEREAL_DEGREES_PER_SECOND;
+
+	gst = fmod(gst, 360.);
+	if (gst < 0.) {
+		gst += 360.;
+	}
+	_secondsSiderealTime = gst;
+}
+
+
+double SiderealClock::localSiderealTime(const double degrees_longitude) {
+	if (!_synchronized) {
+		// Nobody has set the time yet. Use whatever TimeLib currently reports
+		synchronize();
+	}
+
+	unsigned long elapsedMicros = micros() - _secondMicros;
+	if (elapsedMicros >= 1000000UL) {
+		advanceSeconds(elapsedMicros);
+		elapsedMicros %= 1000000UL;
+	}
+
+	// _secondsSiderealTime is < 360 and the sub-second part < 0.005, so this only loops for the longitude
+	double lst = _secondsSiderealTime + elapsedMicros * SIDEREAL_DEGREES_PER_MICROSECOND + degrees_longitude;
+	while (lst < 0.) {
+		lst += 360.;
+	}
+	while (lst >= 360.) {
+		lst -= 360.;
+	}
+
+	return lst;
+}
@@ -0,0 +1,45 @@
+#pragma once
+/*
+ * SiderealClock.h
+ *
+ * Keeps the Greenwich sidereal time without going through the calendar on every update.
+ * The clock is anchored to the TimeLib time once, whenever the time gets set (see the Observer classes).
+ * After that, the sidereal time is advanced from micros() with a single multiply-add per call.
+ * Every full second the sub-second part is folded into the seconds part, so micros() can not overflow
+ * in between and the precision does not degrade over a night even when double is only 32 bits wide (AVR).
+ */
+
+// How far the sidereal time advances per (solar) second, in degrees. This is also the rate at which the sky turns
+const double SIDEREAL_DEGREES_PER_SECOND = 360.98564736629 / 86400.;
+
+class SiderealClock {
+public:
+	// Anchors the clock to the current TimeLib time. Call this right after setTime()
+	void synchronize();
+
+	// Has synchronize() been called yet?
+	bool isSynchronized() {
+		return _synchronized;
+	}
+
+	// The current local sidereal time in degrees (0 <= LST < 360) at the given longitude (in degrees, east positive)
+	double localSiderealTime(const double degrees_longitude);
+
+protected:
+	// Folds whole seconds since the anchor into _secondsSiderealTime
+	void advanceSeconds(const unsigned long elapsedMicros);
+
+	bool _synchronized = false;
+
+	// Greenwich sidereal time in degrees at the time of synchronize()
+	double _anchorSiderealTime = 0;
+
+	// micros() at the start of the current second
+	unsigned long _secondMicros = 0;
+
+	// Whole seconds between synchronize() and _secondMicros
+	unsigned long _elapsedSeconds = 0;
+
+	// Greenwich sidereal time in degrees at _secondMicros
+	double _secondsSiderealTime = 0;
+};
@@ -0,0 +1,138 @@
+#include <Arduino.h>
+
+#include "./config.h"
+
+#include "./SlewPlanner.h"
+
+// Lowers limit to the limit of an axis, divided by its distance. 0 means there is no limit yet
+static void tighten(double& limit, const double axisLimit, const long distance) {
+	if (distance == 0) {
+		return;
+	}
+	const double normalized = axisLimit / labs(distance);
+	if (limit == 0. || normalized < limit) {
+		limit = normalized;
+	}
+}
+
+
+/*
+ * With the speed V, acceleration A and jerk J of s(t), accelerating to V takes V / A + A / J seconds (two jerk phases of
+ * A / J and the rest at A), and covers half of that times V. Decelerating takes the same. Together they must not be more than 1:
+ *     V^2 / A + V A / J <= 1
+ * If they are, V is lowered to the solution of the quadratic equation. If A can not be reached before V (V J < A^2),
+ * the acceleration only has the two jerk phases of sqrt(V / J), and the distance is 2 V sqrt(V / J).
+ * Whatever is left of the distance is covered at V
+ */
+SlewPlanner::Profile SlewPlanner::profile(const AzAlt<long> distance) {
+	const double jerkSeconds = SLEW_JERK_MS / 1000.;
+	double speed = 0.;
+	double acceleration = 0.;
+	double jerk = 0.;
+	tighten(speed, AZ_MAX_SPEED, distance.azimuth);
+	tighten(speed, ALT_MAX_SPEED, distance.altitude);
+	tighten(acceleration, AZ_MAX_ACCEL, distance.azimuth);
+	tighten(acceleration, ALT_MAX_ACCEL, distance.altitude);
+	tighten(jerk, AZ_MAX_ACCEL / jerkSeconds, distance.azimuth);
+	tighten(jerk, ALT_MAX_ACCEL / jerkSeconds, distance.altitude);
+
+	Profile profile = { jerk, 0., 0., 0. };
+	if (speed == 0.) {
+		return profile;
+	}
+
+	if (speed * jerk < acceleration * acceleration) {
+		acceleration = sqrt(speed * jerk);
+	}
+	if (speed * (speed / acceleration + acceleration / jerk) > 1.) {
+		// No cruise
+		const double rampSeconds = acceleration / jerk;
+		speed = acceleration * (sqrt(rampSeconds * rampSeconds + 4. / acceleration) - rampSeconds) / 2.;
+		if (speed * jerk < acceleration * acceleration) {
+			// Neither the maximum acceleration
+			speed = pow(sqrt(jerk) / 2., 2. / 3.);
+			acceleration = sqrt(speed * jerk);
+		}
+	}
+
+	// Rounding may leave tiny negative durations
+	const double accelerationSeconds = speed / acceleration - acceleration / jerk;
+	const double cruiseSeconds = (1. - speed * (speed / acceleration + acceleration / jerk)) / speed;
+	profile.jerkSeconds = acceleration / jerk;
+	profile.accelerationSeconds = accelerationSeconds > 0. ? accelerationSeconds : 0.;
+	profile.cruiseSeconds = cruiseSeconds > 0. ? cruiseSeconds : 0.;
+	return profile;
+}
+
+
+/*
+ * The phases are integrated exactly: within a phase of t seconds with the jerk j
+ *     position     += speed t + acceleration t^2 / 2 + j t^3 / 6
+ *     speed        += acceleration t + j t^2 / 2
+ *     acceleration += j t
+ */
+bool SlewPlanner::plan(const AzAlt<long> from, const AzAlt<long> to) {
+	_from = from;
+	_to = to;
+	_phaseCount = 0;
+	_duration = 0.;
+
+	const AzAlt<long> distance = { to.azimuth - from.azimuth, to.altitude - from.altitude };
+	if (distance.azimuth == 0 && distance.altitude == 0) {
+		return false;
+	}
+
+	const Profile profile = SlewPlanner::profile(distance);
+	const double jerks[SLEW_MAX_PHASES] = {
+		profile.jerk, 0., -profile.jerk, 0., -profile.jerk, 0., profile.jerk
+	};
+	const double durations[SLEW_MAX_PHASES] = {
+		profile.jerkSeconds, profile.accelerationSeconds, profile.jerkSeconds, profile.cruiseSeconds,
+		profile.jerkSeconds, profile.accelerationSeconds, profile.jerkSeconds
+	};
+
+	double position = 0.;
+	double speed = 0.;
+	double acceleration = 0.;
+	for (uint8_t i = 0; i < SLEW_MAX_PHASES; i++) {
+		// Phases shorter than a microsecond would never be started (see Mount::startDueSegments())
+		const double t = durations[i];
+		if (t < 0.000001) {
+			continue;
+		}
+		_phases[_phaseCount++] = { _duration, jerks[i], position, speed, acceleration };
+
+		position += t * (speed + t * (acceleration / 2. + t * jerks[i] / 6.));
+		speed += t * (acceleration + t * jerks[i] / 2.);
+		acceleration += t * jerks[i];
+		_duration += t;
+	}
+	return true;
+}
+
+
+double SlewPlanner::phaseStart(const uint8_t phase) const {
+	return phase < _phaseCount ? _phases[phase].startSeconds : _duration;
+}
+
+
+void SlewPlanner::phaseTrajectories(const uint8_t phase, const double tickSeconds, Trajectory& azimuth, Trajectory& altitude) const {
+	const Phase& p = _phases[phase];
+	const double window = phaseStart(phase + 1) - p.startSeconds;
+
+	const double azimuthDistance = _to.azimuth - _from.azimuth;
+	azimuth.set(_from.azimuth + azimuthDistance * p.position, azimuthDistance * p.speed,
+		azimuthDistance * p.acceleration, azimuthDistance * p.jerk);
+	azimuth.start(0., tickSeconds, window);
+
+	const double altitudeDistance = _to.altitude - _from.altitude;
+	altitude.set(_from.altitude + altitudeDistance * p.position, altitudeDistance * p.speed,
+		altitudeDistance * p.acceleration, altitudeDistance * p.jerk);
+	altitude.start(0., tickSeconds, window);
+}
+
+
+double SlewPlanner::slewSeconds(const AzAlt<long> distance) {
+	const Profile p = profile(distance);
+	return 4. * p.jerkSeconds + 2. * p.accelerationSeconds + p.cruiseSeconds;
+}
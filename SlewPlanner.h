@@ -0,0 +1,82 @@
+#pragma once
+/*
+ * SlewPlanner.h
+ *
+ * Plans a slew (GoTo) of both axes as one jerk-limited (S-curve) profile, so that they start and arrive together.
+ * Instead of a trapezoid for each axis, both axes follow the same profile s(t), which goes from 0 to 1, times their
+ * distance. The mount therefore moves along a straight line in step coordinates. The limits of s(t) are those of the
+ * axis that needs the most time: AZ_MAX_SPEED / azimuth distance or ALT_MAX_SPEED / altitude distance, whichever is
+ * smaller, and the same for the acceleration (AZ_MAX_ACCEL, ALT_MAX_ACCEL) and the jerk (see SLEW_JERK_MS).
+ *
+ * The profile has up to seven phases of constant jerk:
+ *     jerk up, constant acceleration, jerk down, cruise, jerk down, constant deceleration, jerk up
+ * Phases are left out if the distance is too short to reach the maximum acceleration or speed.
+ * Within a phase, the position of each axis is a cubic polynomial. plan() calculates the table of phases before the slew
+ * starts. The mount queues each phase as a trajectory segment (see phaseTrajectories()), which the stepper interrupt
+ * follows just like a tracking trajectory (see Trajectory.h)
+ */
+
+#include <stdint.h>
+
+#include "./Mount.h"
+#include "./Trajectory.h"
+
+// Number of phases of an S-curve profile
+#define SLEW_MAX_PHASES 7
+
+class SlewPlanner {
+public:
+	// Plans the slew between two step positions. Returns false if there is nothing to move
+	bool plan(const AzAlt<long> from, const AzAlt<long> to);
+
+	// Number of phases of the planned slew
+	uint8_t phases() const {
+		return _phaseCount;
+	}
+
+	// Seconds from the start of the slew to the start of the phase. phases() gives the end of the slew
+	double phaseStart(const uint8_t phase) const;
+
+	// Duration of the planned slew in seconds
+	double duration() const {
+		return _duration;
+	}
+
+	// Where the planned slew ends (in steps)
+	AzAlt<long> target() const {
+		return _to;
+	}
+
+	// Sets the trajectories of both axes to the phase and starts them (Trajectory::start()) at the beginning of the phase
+	void phaseTrajectories(const uint8_t phase, const double tickSeconds, Trajectory& azimuth, Trajectory& altitude) const;
+
+	// Seconds a slew over the distance (in steps) takes, without planning it
+	static double slewSeconds(const AzAlt<long> distance);
+
+protected:
+	// Durations of the phases of a profile for the distance 1, in seconds. The same durations apply to both axes
+	struct Profile {
+		double jerk;
+		double jerkSeconds;
+		double accelerationSeconds;
+		double cruiseSeconds;
+	};
+
+	// A phase of the profile s(t), and where s(t) is at its start
+	struct Phase {
+		double startSeconds;
+		double jerk;
+		double position;
+		double speed;
+		double acceleration;
+	};
+
+	static Profile profile(const AzAlt<long> distance);
+
+	Phase _phases[SLEW_MAX_PHASES];
+	uint8_t _phaseCount = 0;
+	double _duration = 0.;
+
+	AzAlt<long> _from = { 0, 0 };
+	AzAlt<long> _to = { 0, 0 };
+};
@@ -0,0 +1,287 @@
+#include <Arduino.h>
+
+#include "./StepGenerator.h"
+
+volatile unsigned long StepGenerator::_worstTickMicros = 0;
+
+
+void StepGenerator::moveTo(long absolute) {
+	if (_rampFromSpeed) {
+		// Distance needed to stop from the current speed: speed^2 / (2 * acceleration), in steps
+		_rampFromSpeed = false;
+		const float speed = _interval ? 256000000.f / _interval : 0.f;
+		_rampSteps = static_cast<unsigned long>(speed * speed / (2.f * _accelerationPerSecond));
+	}
+	_targetPos = absolute;
+}
+
+
+void StepGenerator::move(long relative) {
+	moveTo(_currentPos + relative);
+}
+
+
+unsigned long StepGenerator::run(const unsigned long elapsedMicros) {
+	if (_interval == 0) {
+		if (_targetPos == _currentPos) {
+			return NO_STEP_DUE;
+		}
+		// Starting from standstill, possibly after overshooting the target
+		setDirection(_targetPos > _currentPos ? 1 : -1);
+		_rampSteps = 0;
+		_rampRemainder = 0;
+		_sinceStep = 0;
+		_interval = _firstInterval;
+		return waitFor(_interval);
+	}
+
+	addElapsed(elapsedMicros);
+	if (_sinceStep < _interval) {
+		return waitFor(_interval);
+	}
+	step();
+	_sinceStep -= _interval;
+
+	// Steps left in the direction of movement. Negative after passing the target
+	long distance = _targetPos - _currentPos;
+	if (_direction < 0) {
+		distance = -distance;
+	}
+
+	if (distance <= static_cast<long>(_rampSteps) || _interval < _minInterval) {
+		// Within the stopping distance, past the target, or above a lowered maximum speed
+		if (_rampSteps <= 1) {
+			// Stopped. At the target, or the next call turns around
+			_interval = 0;
+			_rampSteps = 0;
+			return distance == 0 ? NO_STEP_DUE : 0;
+		}
+		const unsigned long change = 2 * _interval + _rampRemainder;
+		const unsigned long divisor = 4 * _rampSteps - 1;
+		_interval += change / divisor;
+		_rampRemainder = change % divisor;
+		if (_interval > MAX_STEP_INTERVAL) {
+			_interval = MAX_STEP_INTERVAL;
+		}
+		_rampSteps--;
+	}
+	else if (_interval > _minInterval) {
+		// Slower than the first step of a ramp (after runSpeed()) starts the ramp over
+		if (_interval > _firstInterval) {
+			_interval = _firstInterval;
+			_rampSteps = 0;
+		}
+		_rampSteps++;
+		const unsigned long change = 2 * _interval + _rampRemainder;
+		const unsigned long divisor = 4 * _rampSteps + 1;
+		_interval -= change / divisor;
+		_rampRemainder = change % divisor;
+		if (_interval < _minInterval) {
+			_interval = _minInterval;
+		}
+	}
+
+	return waitFor(_interval);
+}
+
+
+unsigned long StepGenerator::runSpeed(const unsigned long elapsedMicros) {
+	if (_interval == 0) {
+		return NO_STEP_DUE;
+	}
+
+	addElapsed(elapsedMicros);
+	if (_sinceStep >= _interval) {
+		step();
+		_sinceStep -= _interval;
+	}
+	return waitFor(_interval);
+}
+
+
+unsigned long StepGenerator::stepTowards(const long target, const unsigned long elapsedMicros) {
+	// The speed along the trajectory is unknown. This is what run() expects
+	_interval = 0;
+	_rampSteps = 0;
+
+	addElapsed(elapsedMicros);
+	if (target == _currentPos) {
+		return NO_STEP_DUE;
+	}
+	if (_sinceStep < _minInterval) {
+		return waitFor(_minInterval);
+	}
+
+	setDirection(target > _currentPos ? 1 : -1);
+	step();
+	_sinceStep = 0;
+	return target == _currentPos ? NO_STEP_DUE : waitFor(_minInterval);
+}
+
+
+void StepGenerator::setMaxSpeed(float speed) {
+	_maxSpeedPerSecond = fabs(speed);
+	_minInterval = toInterval(speed);
+	if (_minInterval == 0) {
+		_minInterval = MAX_STEP_INTERVAL;
+	}
+}
+
+
+float StepGenerator::maxSpeed() {
+	return _maxSpeedPerSecond;
+}
+
+
+// The first interval is 0.676 * sqrt(2 / acceleration) seconds. The factor corrects the error of Austin's approximation for the first step
+void StepGenerator::setAcceleration(float acceleration) {
+	_accelerationPerSecond = fabs(acceleration);
+	const float seconds = 0.676f * sqrt(2.f / _accelerationPerSecond);
+	_firstInterval = seconds < MAX_STEP_INTERVAL / 256000000.f
+		? static_cast<unsigned long>(seconds * 256000000.f)
+		: MAX_STEP_INTERVAL;
+}
+
+
+// Like AccelStepper, the speed is limited to the maximum speed
+void StepGenerator::setSpeed(float speed) {
+	unsigned long interval = toInterval(speed);
+	if (interval != 0 && interval < _minInterval) {
+		interval = _minInterval;
+	}
+	_interval = interval;
+	if (speed != 0.f) {
+		setDirection(speed > 0.f ? 1 : -1);
+	}
+	_rampFromSpeed = true;
+}
+
+
+float StepGenerator::speed() {
+	const float speed = _interval ? 256000000.f / _interval : 0.f;
+	return _direction < 0 ? -speed : speed;
+}
+
+
+long StepGenerator::distanceToGo() {
+	return _targetPos - _currentPos;
+}
+
+
+long StepGenerator::targetPosition() {
+	return _targetPos;
+}
+
+
+long StepGenerator::currentPosition() {
+	return _currentPos;
+}
+
+
+void StepGenerator::setCurrentPosition(long position) {
+	_targetPos = _currentPos = position;
+	_interval = 0;
+	_sinceStep = 0;
+	_rampSteps = 0;
+}
+
+
+void StepGenerator::stop() {
+	moveTo(_currentPos + _direction * static_cast<long>(_rampSteps));
+}
+
+
+bool StepGenerator::isRunning() {
+	return _interval != 0 || _targetPos != _currentPos;
+}
+
+
+void StepGenerator::setMinPulseWidth(unsigned int minWidth) {
+	_minPulseWidth = minWidth;
+}
+
+
+// There is no enable pin. The sketch switches the drivers with AZ_ENABLE_PIN and ALT_ENABLE_PIN itself
+void StepGenerator::setPinsInverted(bool directionInvert, bool stepInvert, bool) {
+	_dirInverted = directionInvert;
+	_stepInverted = stepInvert;
+	_writeStep(_stepInverted);
+
+	// Writes the DIR pin again with the new inversion
+	const int8_t direction = _direction;
+	_direction = 0;
+	if (direction != 0) {
+		setDirection(direction);
+	}
+}
+
+
+void StepGenerator::step() {
+	_currentPos += _direction;
+	_writeStep(!_stepInverted);
+	delayMicroseconds(_minPulseWidth);
+	_writeStep(_stepInverted);
+}
+
+
+// Like AccelStepper's driver interface, DIR is HIGH for positive steps (unless inverted)
+void StepGenerator::setDirection(const int8_t direction) {
+	if (direction == _direction) {
+		return;
+	}
+	_direction = direction;
+	_writeDirection((direction > 0) != _dirInverted);
+}
+
+
+// The interrupt runs at least every STEP_TIMER_MAX_MICROS, so this can only exceed MAX_STEP_INTERVAL by that much
+void StepGenerator::addElapsed(const unsigned long elapsedMicros) {
+	_sinceStep += elapsedMicros << 8;
+	if (_sinceStep > MAX_STEP_INTERVAL) {
+		_sinceStep = MAX_STEP_INTERVAL;
+	}
+}
+
+
+unsigned long StepGenerator::waitFor(const unsigned long interval) {
+	return _sinceStep < interval ? (interval - _sinceStep + 255) >> 8 : 0;
+}
+
+
+unsigned long StepGenerator::toInterval(const float speed) {
+	const float steps = fabs(speed);
+	if (steps * MAX_STEP_INTERVAL <= 256000000.f) {
+		return steps == 0.f ? 0 : MAX_STEP_INTERVAL;
+	}
+	return static_cast<unsigned long>(256000000.f / steps);
+}
+
+
+unsigned long StepGenerator::startTick() {
+	return micros();
+}
+
+
+unsigned long StepGenerator::endTick(const unsigned long startMicros) {
+	const unsigned long duration = micros() - startMicros;
+	if (duration > _worstTickMicros) {
+		_worstTickMicros = duration;
+	}
+	return duration;
+}
+
+
+// unsigned long is not written atomically on the Mega, so the interrupt must not run while it is read
+unsigned long StepGenerator::worstTickMicros() {
+	noInterrupts();
+	const unsigned long worst = _worstTickMicros;
+	interrupts();
+	return worst;
+}
+
+
+void StepGenerator::resetWorstTick() {
+	noInterrupts();
+	_worstTickMicros = 0;
+	interrupts();
+}
@@ -0,0 +1,176 @@
+#pragma once
+/*
+ * StepGenerator.h
+ *
+ * Step pulses for a stepper driver (STEP/DIR interface), generated by the stepper interrupt.
+ * It has the AccelStepper methods the mounts use, so it replaces the AccelStepper instances
+ * in dobson-star-tracker.ino (see STEP_GENERATOR in config.h and MountStepper below).
+ *
+ * The stepper interrupt is not periodic. Each call of run(), runSpeed() or stepTowards() gets the time since the
+ * previous call, makes a step if one is due and returns the time until the next step is due. The interrupt is
+ * scheduled for the earliest step of both steppers (see moveSteppers() in dobson-star-tracker.ino), so there are
+ * no interrupts without a step, except for one every STEP_TIMER_MAX_MICROS.
+ *
+ * The time between two steps (the step interval) is integer math only. Accelerating and decelerating follows
+ * David Austin's approximation of the ramp (also used by AccelStepper, in float): the n-th interval is
+ *     c(n) = c(n - 1) - 2 c(n - 1) / (4 n + 1)
+ * This is one 32 bit division per step while the speed changes, and none at a constant speed. The remainder of the
+ * division is carried over to the next step, because the change of the interval soon becomes less than its resolution.
+ * Deceleration starts when the remaining distance is not more than the number of steps made while accelerating,
+ * because decelerating with the same rate takes just as many steps.
+ *
+ * Step intervals are unsigned long Q24.8 microseconds (up to 8 seconds, see MAX_STEP_INTERVAL)
+ *
+ * The pins are template parameters of the constructor (see StepperPins), so the step pulses are written with FastPin
+ * instead of digitalWrite()
+ */
+
+#include <AccelStepper.h>
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "./config.h"
+#include "./FastPin.h"
+
+// Returned instead of the time until the next step, if no step is due (the stepper stands still)
+const unsigned long NO_STEP_DUE = 0xFFFFFFFFUL;
+
+// The STEP and DIR pins of a stepper driver, for the constructor of StepGenerator. Only the driver interface is supported
+template<uint8_t StepPin, uint8_t DirPin>
+struct StepperPins {};
+
+class StepGenerator {
+public:
+	template<uint8_t StepPin, uint8_t DirPin>
+	StepGenerator(StepperPins<StepPin, DirPin>) :
+			_writeStep(&FastPin<StepPin>::writeLevel), _writeDirection(&FastPin<DirPin>::writeLevel) {
+		FastPin<StepPin>::setOutput();
+		FastPin<DirPin>::setOutput();
+	}
+
+	// Sets the target position in steps. run() accelerates towards it, or decelerates and turns around first
+	void moveTo(long absolute);
+	void move(long relative);
+
+	/*
+	 * Called by the stepper interrupt, elapsedMicros after the previous call of any of these three.
+	 * They make at most one step and return the microseconds until the next step is due, or NO_STEP_DUE
+	 */
+
+	// Moves towards the target position, with acceleration
+	unsigned long run(const unsigned long elapsedMicros);
+
+	// Moves at the speed set by setSpeed(), without acceleration
+	unsigned long runSpeed(const unsigned long elapsedMicros);
+
+	// Makes a step towards target, unless the stepper is already there or the last step was less than 1 / max speed ago.
+	// run() continues from standstill afterwards
+	unsigned long stepTowards(const long target, const unsigned long elapsedMicros);
+
+	// Speed in steps per second (always positive)
+	void setMaxSpeed(float speed);
+	float maxSpeed();
+
+	// Acceleration in steps per second^2 (always positive)
+	void setAcceleration(float acceleration);
+
+	// Speed for runSpeed() in steps per second. Negative values move backwards
+	void setSpeed(float speed);
+	float speed();
+
+	long distanceToGo();
+	long targetPosition();
+	long currentPosition();
+
+	// Sets the current position (and the target position) without moving. Stops immediately
+	void setCurrentPosition(long position);
+
+	// Sets the target position to where run() can come to a stop
+	void stop();
+	bool isRunning();
+
+	void setMinPulseWidth(unsigned int minWidth);
+	void setPinsInverted(bool directionInvert = false, bool stepInvert = false, bool enableInvert = false);
+
+	/*
+	 * Timing of the stepper interrupt
+	 * moveSteppers() calls startTick() at the beginning and endTick() at the end. The longest interrupt since the last
+	 * resetWorstTick() is kept. endTick() returns the duration, for the histogram of Profiler::recordTick().
+	 * micros() has a resolution of 4 microseconds on the Mega
+	 */
+	static unsigned long startTick();
+	static unsigned long endTick(const unsigned long startMicros);
+	static unsigned long worstTickMicros();
+	static void resetWorstTick();
+
+protected:
+	// Longest step interval. Twice this plus the remainder of the ramp still fits into an unsigned long
+	static const unsigned long MAX_STEP_INTERVAL = 0x7FFF0000UL;
+
+	// Makes one step in _direction and updates _currentPos
+	void step();
+
+	// Sets _direction and writes the DIR pin, if the direction changed
+	void setDirection(const int8_t direction);
+
+	// Adds the elapsed time to _sinceStep
+	void addElapsed(const unsigned long elapsedMicros);
+
+	// Microseconds from now until _sinceStep reaches interval, rounded up
+	unsigned long waitFor(const unsigned long interval);
+
+	// Step interval for a speed in steps per second. 0 for standstill
+	static unsigned long toInterval(const float speed);
+
+	// Write the STEP and DIR pins. FastPin<...>::writeLevel() of the pins passed to the constructor
+	typedef void (*PinWriter)(const bool high);
+	PinWriter _writeStep;
+	PinWriter _writeDirection;
+	bool _stepInverted = false;
+	bool _dirInverted = false;
+	unsigned int _minPulseWidth = 1;
+
+	volatile long _currentPos = 0;
+	volatile long _targetPos = 0;
+
+	// Direction of the current movement. 1 moves towards larger positions, -1 towards smaller ones. 0 before the first one
+	int8_t _direction = 0;
+
+	// Interval from the last step to the next one. 0 while standing still
+	unsigned long _interval = 0;
+
+	// Time since the last step
+	unsigned long _sinceStep = 0;
+
+	// Interval at the maximum speed
+	unsigned long _minInterval = MAX_STEP_INTERVAL;
+
+	// Interval of the first step from standstill, which depends on the acceleration
+	unsigned long _firstInterval = MAX_STEP_INTERVAL;
+
+	// Steps made while accelerating, minus steps made while decelerating. This is the distance needed to stop
+	unsigned long _rampSteps = 0;
+
+	// Remainder of the last division of the ramp
+	unsigned long _rampRemainder = 0;
+
+	// Set by setSpeed(). The next moveTo() calculates _rampSteps from the speed, so that run() can take over from runSpeed()
+	bool _rampFromSpeed = false;
+
+	// Parameters as set, for maxSpeed() and moveTo()
+	float _maxSpeedPerSecond = 0.f;
+	float _accelerationPerSecond = 0.f;
+
+	// Longest stepper interrupt in microseconds
+	static volatile unsigned long _worstTickMicros;
+};
+
+
+// The stepper class used by dobson-star-tracker.ino and the mounts, and the arguments of its constructor
+#ifdef STEP_GENERATOR
+typedef StepGenerator MountStepper;
+#define MOUNT_STEPPER_PINS(stepPin, dirPin) StepperPins<stepPin, dirPin>{}
+#else
+typedef AccelStepper MountStepper;
+#define MOUNT_STEPPER_PINS(stepPin, dirPin) AccelStepper::DRIVER, stepPin, dirPin
+#endif
@@ -0,0 +1,187 @@
+#include <Arduino.h>
+
+#include "./conversion.h"
+#include "./FastPin.h"
+#include "./SerialOutput.h"
+#include "./Tasks.h"
+#include "./Telemetry.h"
+#include "./TimedActions.h"
+
+#ifdef SERIAL_DISPLAY_ENABLED
+	#include "./display_unit.h"
+#endif
+
+// Are the stepper drivers currently enabled?
+bool motorsEnabled = false;
+
+
+/*
+ * This function turns stepper motor drivers on, if these conditions are met:
+ * STEPPERS_ON_PIN reads HIGH
+ * operating mode is not Mode::INITIALIZING
+ * no :DBGDM## pause is running (see steppersPaused())
+ * TODO Maybe the conditions need to change (esp. the opmode one)
+ */
+void setSteppersOnOffState() {
+	const bool isTracking = scope.getMode() == Mode::TRACKING;
+
+#ifdef STEPPERS_ON_PIN
+	// If the STEPPERS_ON switch is installed, check its state
+	const bool steppersSwitchOn = digitalRead(STEPPERS_ON_PIN) == HIGH;
+#else
+	// If no STEPPERS_ON switch is installed, define its state as enabled
+#define steppersSwitchOn true
+#endif
+
+	if (steppersSwitchOn && isTracking && !steppersPaused()) {
+		// Motors on
+		motorsEnabled = true;
+#ifdef AZ_ENABLE
+		FastPin<AZ_ENABLE_PIN>::write(LOW);
+#endif
+#ifdef ALT_ENABLE
+		FastPin<ALT_ENABLE_PIN>::write(LOW);
+#endif
+	}
+	else {
+		// Motors OFF
+		motorsEnabled = false;
+#ifdef AZ_ENABLE
+		FastPin<AZ_ENABLE_PIN>::write(HIGH);
+#endif
+#ifdef ALT_ENABLE
+		FastPin<ALT_ENABLE_PIN>::write(HIGH);
+#endif
+	}
+}
+
+
+/*
+ * Tasks of the main loop
+ */
+
+// Calculates the target of the telescope and updates the target of the steppers, when the mount asks for it (see Mount::isUpdateDue())
+void motorUpdateTask() {
+	if (!scope.isUpdateDue()) {
+		return;
+	}
+
+	#if defined(DEBUG) && defined(DEBUG_SERIAL_STEPPER_MOVEMENT) && defined(DEBUG_TIMING)
+		// Start timing the calculation
+		long micros_start = micros();
+	#endif
+
+	// This function converts the coordinates
+	scope.calculateMotorTargets();
+
+	// This actually makes the motors move to their desired target positions
+	#ifdef MOUNT_STOP_UNTIL_GPS_POS_VALID
+		if (observer.hasValidPosition()) {
+			scope.move();
+		}
+	#else
+		scope.move();
+	#endif
+	scope.scheduleUpdate();
+
+	#if defined(DEBUG) && defined(DEBUG_SERIAL_STEPPER_MOVEMENT) && defined(DEBUG_TIMING)
+		// Debug: If a move took place, output how long it took from beginning to end of the calculation
+		if (scope._didMove) {
+			long calc_time = scope._lastCalcMicros - micros_start;
+			long dbg_time = micros() - scope._lastCalcMicros;
+			DEBUG_PRINT("; Calc: ");
+			DEBUG_PRINT(calc_time / 1000.);
+			DEBUG_PRINT("ms; DbgComms: ");
+			DEBUG_PRINT(dbg_time / 1000.);
+			DEBUG_PRINTLN("ms");
+		}
+	#endif
+}
+
+
+// Reads the HOME button and turns the stepper drivers on or off
+void controlsTask() {
+	#ifdef HOME_NOW_PIN
+		// If the HOME button is installed and pressed/switched on, the telescope assumes it is pointing at the target
+		if (digitalRead(HOME_NOW_PIN) == HIGH) {
+			// Setting homed to false also sets the telescope to operating mode Mode::ALIGNING, setting it to true to Mode::TRACKING
+			scope.setHomed(false);
+			scope.setHomed(true);
+		}
+	#endif
+
+	// Turn the stepper motors on or off, depending on state of STEPPERS_ON_PIN
+	setSteppersOnOffState();
+}
+
+
+// Runs the one-shot actions that are due, e.g. the end of a beep (see TimedActions.h)
+void timersTask() {
+	TimedActions::runDue();
+}
+
+
+// Get the current position from our GPS module. If no GPS is installed
+// or no fix is available values from EEPROM / config.h are used.
+// For more details look at the implementations of the Observer class
+// A new position changes the targets of the steppers right away
+void observerTask() {
+	static unsigned int observerVersion = 0;
+
+	observer.updatePosition();
+	if (observer.trigonometry().version != observerVersion) {
+		observerVersion = observer.trigonometry().version;
+		scope.requestUpdate();
+	}
+}
+
+
+// Handles the serial communication with Stellarium
+void serialTask() {
+	// Returns true if aligning was just performed. That sets the telescope to operating mode Mode::TRACKING
+	if (handleSerialCommunication(scope, observer)) {
+		scope.setHomed(true);
+	}
+
+	// Sends the buffered replies and debug messages, as far as the serial port takes them right now
+	SerialOutput::flush();
+}
+
+
+// Sends the next frame of the telemetry stream, if it runs and a frame is due (see Telemetry.h)
+void telemetryTask() {
+	Telemetry::update(scope);
+}
+
+
+#ifdef SERIAL_DISPLAY_ENABLED
+	void displayTask() {
+		handleDisplayCommunication(scope, observer);
+	}
+#endif
+
+
+/*
+ * Periods, deadlines (both in microseconds) and priorities of the tasks
+ * The motor update has the highest priority, so serial traffic can not delay it by more than one command.
+ * It checks every UPDATE_MOTOR_POS_MIN_MS whether the mount needs an update.
+ * The GPS module, the serial ports and the telemetry stream are polled whenever nothing more important is due.
+ * These have period 0, so they are always due. They must share the same priority: A poller with a higher priority would
+ * run every time and starve the others. Among equal priorities the task that ran least recently goes first, so they take turns.
+ * The deadlines of the pollers only decide when a wait counts as an overrun. The GPS module has the shortest one, because its
+ * sentences are lost once the receive buffer of its serial port overflows.
+ * The telemetry task keeps its own frame rate (see Telemetry.h)
+ */
+SchedulerTask tasks[] = {
+	{ "motor", &motorUpdateTask, UPDATE_MOTOR_POS_MIN_MS * 1000UL, 10000, 4, 0, 0, 0, 0, 0, 0 },
+	{ "controls", &controlsTask, 20000, 20000, 3, 0, 0, 0, 0, 0, 0 },
+	{ "timers", &timersTask, 10000, 10000, 3, 0, 0, 0, 0, 0, 0 },
+	{ "observer", &observerTask, 0, 5000, 1, 0, 0, 0, 0, 0, 0 },
+	{ "serial", &serialTask, 0, 10000, 1, 0, 0, 0, 0, 0, 0 },
+	{ "telemetry", &telemetryTask, 0, 10000, 1, 0, 0, 0, 0, 0, 0 },
+#ifdef SERIAL_DISPLAY_ENABLED
+	{ "display", &displayTask, 0, 20000, 1, 0, 0, 0, 0, 0, 0 },
+#endif
+};
+
+Scheduler scheduler(tasks, sizeof(tasks) / sizeof(tasks[0]));
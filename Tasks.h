@@ -0,0 +1,63 @@
+#pragma once
+/*
+ * Tasks.h
+ *
+ * The tasks of loop() and their table for the scheduler (see Scheduler.h), both in Tasks.cpp.
+ * They work on the mount and the observer of the sketch (dobson-star-tracker.ino), whose setup() starts the scheduler.
+ * The host build links the same tasks. There, host/test/tasks_test.cpp defines the mount and the observer
+ */
+
+#include "./config.h"
+#include "./Scheduler.h"
+
+// The observer and the mount, of the types selected in config.h. Defined by the sketch
+#ifdef GPS_FIXED_POS
+	#include "./FixedObserver.h"
+	extern FixedObserver observer;
+#else
+	#include "./GpsObserver.h"
+	extern GpsObserver observer;
+#endif
+
+#ifdef MOUNT_TYPE_DOBSON
+	#include "./Dobson.h"
+	extern Dobson scope;
+#elif defined MOUNT_TYPE_EQUATORIAL
+	#include "./Equatorial.h" // NOT IMPLEMENTED!
+	extern Equatorial scope;
+#elif defined MOUNT_TYPE_DIRECT
+	#include "./DirectDrive.h"
+	extern DirectDrive scope;
+#endif
+
+// Are the stepper drivers currently enabled?
+extern bool motorsEnabled;
+
+// Turns the stepper drivers on or off (see Tasks.cpp)
+void setSteppersOnOffState();
+
+// Calculates the target of the telescope and updates the target of the steppers, when the mount asks for it
+void motorUpdateTask();
+
+// Reads the HOME button and turns the stepper drivers on or off
+void controlsTask();
+
+// Runs the one-shot actions that are due (see TimedActions.h)
+void timersTask();
+
+// Polls the GPS module
+void observerTask();
+
+// Handles the serial communication with Stellarium and sends the buffered output
+void serialTask();
+
+// Sends the next frame of the telemetry stream (see Telemetry.h)
+void telemetryTask();
+
+#ifdef SERIAL_DISPLAY_ENABLED
+	// Handles the serial communication with the display unit
+	void displayTask();
+#endif
+
+extern SchedulerTask tasks[];
+extern Scheduler scheduler;
@@ -0,0 +1,172 @@
+#include <Arduino.h>
+#include <string.h>
+
+#include "./Profiler.h"
+#include "./SerialOutput.h"
+#include "./Telemetry.h"
+
+unsigned long Telemetry::_intervalMicros = 0;
+unsigned long Telemetry::_nextFrameMicros = 0;
+unsigned long Telemetry::_droppedFrames = 0;
+
+
+// Little endian helpers for encode() and decode(). They return the position after the value
+static uint8_t* writeUint32(uint8_t* data, const uint32_t value) {
+	data[0] = value;
+	data[1] = value >> 8;
+	data[2] = value >> 16;
+	data[3] = value >> 24;
+	return data + 4;
+}
+
+static uint8_t* writeUint16(uint8_t* data, const uint16_t value) {
+	data[0] = value;
+	data[1] = value >> 8;
+	return data + 2;
+}
+
+static uint8_t* writeFloat(uint8_t* data, const float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return writeUint32(data, bits);
+}
+
+static const uint8_t* readUint32(const uint8_t* data, uint32_t& value) {
+	value = static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 | static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+	return data + 4;
+}
+
+static const uint8_t* readInt32(const uint8_t* data, long& value) {
+	uint32_t bits;
+	data = readUint32(data, bits);
+	value = static_cast<int32_t>(bits);
+	return data;
+}
+
+static const uint8_t* readUint16(const uint8_t* data, uint16_t& value) {
+	value = static_cast<uint16_t>(data[0] | data[1] << 8);
+	return data + 2;
+}
+
+static const uint8_t* readFloat(const uint8_t* data, float& value) {
+	uint32_t bits;
+	data = readUint32(data, bits);
+	memcpy(&value, &bits, sizeof(value));
+	return data;
+}
+
+static uint8_t checksum(const uint8_t* payload) {
+	uint8_t sum = 0;
+	for (uint8_t i = 0; i < Telemetry::PAYLOAD_SIZE; i++) {
+		sum ^= payload[i];
+	}
+	return sum;
+}
+
+// Microseconds as 16 bits. Longer durations are reported as 65535
+static uint16_t saturate(const unsigned long micros) {
+	return micros > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(micros);
+}
+
+
+void Telemetry::start(const uint8_t rate) {
+	if (rate == 0) {
+		_intervalMicros = 0;
+		SerialOutput::setDebugPaused(false);
+		return;
+	}
+
+	_intervalMicros = 1000000UL / (rate > MAX_RATE ? MAX_RATE : rate);
+	_nextFrameMicros = micros();
+	_droppedFrames = 0;
+
+	// The peaks of the first frame start now
+	unsigned long loopMicros, tickMicros;
+	Profiler::takePeaks(loopMicros, tickMicros);
+	SerialOutput::setDebugPaused(true);
+}
+
+
+void Telemetry::update(Mount& mount) {
+	if (_intervalMicros == 0) {
+		return;
+	}
+
+	const unsigned long now = micros();
+	if ((long)(now - _nextFrameMicros) < 0) {
+		return;
+	}
+	// Keep the rate, unless the frames fell behind by more than one interval
+	_nextFrameMicros += _intervalMicros;
+	if ((long)(now - _nextFrameMicros) >= 0) {
+		_nextFrameMicros = now + _intervalMicros;
+	}
+
+	TelemetryFrame frame;
+	frame.timestamp = now;
+	const RaDecPosition target = mount.getTarget();
+	frame.targetRa = target.rightAscension;
+	frame.targetDec = target.declination;
+	frame.commanded = mount.getSteppersTarget();
+	frame.actual = mount.stepperSnapshot().position;
+	frame.mode = mount.getMode();
+	unsigned long loopMicros, tickMicros;
+	Profiler::takePeaks(loopMicros, tickMicros);
+	frame.loopMicros = saturate(loopMicros);
+	frame.tickMicros = saturate(tickMicros);
+
+	// Replies go first. Waiting for the port would delay loop() as much as the text output did
+	if (SerialReplies.pending() > 0 || Serial.availableForWrite() < FRAME_SIZE) {
+		_droppedFrames++;
+		return;
+	}
+
+	uint8_t data[FRAME_SIZE];
+	encode(frame, data);
+	Serial.write(data, FRAME_SIZE);
+}
+
+
+void Telemetry::encode(const TelemetryFrame& frame, uint8_t* data) {
+	data[0] = SYNC_1;
+	data[1] = SYNC_2;
+	data[2] = PAYLOAD_SIZE;
+
+	uint8_t* payload = data + 3;
+	uint8_t* next = writeUint32(payload, frame.timestamp);
+	next = writeFloat(next, frame.targetRa);
+	next = writeFloat(next, frame.targetDec);
+	next = writeUint32(next, frame.commanded.azimuth);
+	next = writeUint32(next, frame.commanded.altitude);
+	next = writeUint32(next, frame.actual.azimuth);
+	next = writeUint32(next, frame.actual.altitude);
+	*next++ = frame.mode;
+	next = writeUint16(next, frame.loopMicros);
+	next = writeUint16(next, frame.tickMicros);
+	*next = checksum(payload);
+}
+
+
+bool Telemetry::decode(const uint8_t* data, TelemetryFrame& frame) {
+	if (data[0] != SYNC_1 || data[1] != SYNC_2 || data[2] != PAYLOAD_SIZE) {
+		return false;
+	}
+	const uint8_t* payload = data + 3;
+	if (payload[PAYLOAD_SIZE] != checksum(payload)) {
+		return false;
+	}
+
+	uint32_t timestamp;
+	const uint8_t* next = readUint32(payload, timestamp);
+	frame.timestamp = timestamp;
+	next = readFloat(next, frame.targetRa);
+	next = readFloat(next, frame.targetDec);
+	next = readInt32(next, frame.commanded.azimuth);
+	next = readInt32(next, frame.commanded.altitude);
+	next = readInt32(next, frame.actual.azimuth);
+	next = readInt32(next, frame.actual.altitude);
+	frame.mode = *next++;
+	next = readUint16(next, frame.loopMicros);
+	readUint16(next, frame.tickMicros);
+	return true;
+}
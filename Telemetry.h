@@ -0,0 +1,82 @@
+#pragma once
+/*
+ * Telemetry.h
+ *
+ * Binary telemetry stream on the Stellarium / console port (Serial), for recording how the mount tracks over a whole night.
+ * :TLM<rate># sends rate frames per second (1 - MAX_RATE), :TLM0# stops the stream.
+ * host/tools/telemetry_csv.cpp turns a recording of the port into a CSV file.
+ *
+ * A frame is FRAME_SIZE bytes, all numbers little endian:
+ *
+ *     0   SYNC_1, SYNC_2
+ *     2   PAYLOAD_SIZE
+ *     3   payload (see TelemetryFrame)
+ *         uint32  timestamp         micros() when the frame was taken
+ *         float   targetRa          Target right ascension (degrees)
+ *         float   targetDec         Target declination (degrees)
+ *         int32   commandedAz/Alt   Stepper target of the last motor update (steps)
+ *         int32   actualAz/Alt      Stepper position of the last stepper interrupt (steps)
+ *         uint8   mode              Mode of the mount (see Mount.h)
+ *         uint16  loopMicros        Longest loop() iteration since the previous frame
+ *         uint16  tickMicros        Longest stepper interrupt since the previous frame
+ *     36  XOR of the payload bytes
+ *
+ * Replies to commands can come between two frames. A decoder finds the next frame by its sync bytes, size and checksum.
+ * A frame is only sent if it fits into the hardware TX buffer of the port right away. Otherwise it is dropped and counted.
+ * Debug messages are held back while the stream runs (see SerialOutput::setDebugPaused())
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "./config.h"
+#include "./Mount.h"
+
+// The payload of a frame
+struct TelemetryFrame {
+	unsigned long timestamp;
+	float targetRa;
+	float targetDec;
+	AzAlt<long> commanded;
+	AzAlt<long> actual;
+	uint8_t mode;
+	uint16_t loopMicros;
+	uint16_t tickMicros;
+};
+
+
+class Telemetry {
+public:
+	static const uint8_t MAX_RATE = 50;
+
+	static const uint8_t SYNC_1 = 0xA5;
+	static const uint8_t SYNC_2 = 0x5A;
+	static const uint8_t PAYLOAD_SIZE = 33;
+	static const uint8_t FRAME_SIZE = PAYLOAD_SIZE + 4;
+
+	// Starts the stream with rate frames per second (up to MAX_RATE), or stops it if rate is 0
+	static void start(const uint8_t rate);
+
+	static bool isRunning() {
+		return _intervalMicros != 0;
+	}
+
+	// Sends the next frame once it is due. Called by the telemetry task
+	static void update(Mount& mount);
+
+	// Frames that did not fit into the TX buffer since the stream was started
+	static unsigned long droppedFrames() {
+		return _droppedFrames;
+	}
+
+	// Writes frame into data, which must have room for FRAME_SIZE bytes
+	static void encode(const TelemetryFrame& frame, uint8_t* data);
+
+	// Reads a frame from FRAME_SIZE bytes at data. Returns false if they are not a frame
+	static bool decode(const uint8_t* data, TelemetryFrame& frame);
+
+protected:
+	static unsigned long _intervalMicros;
+	static unsigned long _nextFrameMicros;
+	static unsigned long _droppedFrames;
+};
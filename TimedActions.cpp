@@ -0,0 +1,61 @@
+#include <Arduino.h>
+
+#include "./TimedActions.h"
+
+TimedActions::Entry TimedActions::_entries[TimedActions::CAPACITY] = {};
+
+
+bool TimedActions::start(Action action, const unsigned long delayMillis) {
+	const unsigned long due = millis() + delayMillis;
+
+	Entry* free = nullptr;
+	for (uint8_t i = 0; i < CAPACITY; i++) {
+		if (_entries[i].action == action) {
+			_entries[i].dueMillis = due;
+			return true;
+		}
+		if (_entries[i].action == nullptr && free == nullptr) {
+			free = &_entries[i];
+		}
+	}
+	if (free == nullptr) {
+		return false;
+	}
+
+	free->action = action;
+	free->dueMillis = due;
+	return true;
+}
+
+
+void TimedActions::cancel(Action action) {
+	for (uint8_t i = 0; i < CAPACITY; i++) {
+		if (_entries[i].action == action) {
+			_entries[i].action = nullptr;
+		}
+	}
+}
+
+
+bool TimedActions::isPending(Action action) {
+	for (uint8_t i = 0; i < CAPACITY; i++) {
+		if (_entries[i].action == action) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void TimedActions::runDue() {
+	const unsigned long now = millis();
+	for (uint8_t i = 0; i < CAPACITY; i++) {
+		const Action action = _entries[i].action;
+		if (action == nullptr || (long)(now - _entries[i].dueMillis) < 0) {
+			continue;
+		}
+		// Free the entry first, so that the action can start itself again
+		_entries[i].action = nullptr;
+		action();
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+/*
+ * TimedActions.h
+ *
+ * One-shot actions that run a set time from now, instead of waiting for that time with delay().
+ * delay() stops the main loop, so nothing else (tracking updates, Stellarium's commands) is handled meanwhile.
+ *
+ * The actions are run by the "timers" task of the main loop (see dobson-star-tracker.ino), so they run up to one
+ * period of that task late. There is room for CAPACITY pending actions. Each action can only be pending once:
+ * starting it again moves its time instead of adding it a second time
+ */
+
+#include <stdint.h>
+
+class TimedActions {
+public:
+	typedef void (*Action)();
+
+	static const uint8_t CAPACITY = 4;
+
+	// Runs action delayMillis from now. Returns false if there are already CAPACITY other actions pending
+	static bool start(Action action, const unsigned long delayMillis);
+
+	// Removes the action, if it is pending
+	static void cancel(Action action);
+
+	static bool isPending(Action action);
+
+	// Runs and removes all actions that are due
+	static void runDue();
+
+protected:
+	struct Entry {
+		// nullptr if the entry is free
+		Action action;
+		unsigned long dueMillis;
+	};
+
+	static Entry _entries[CAPACITY];
+};
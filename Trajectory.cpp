@@ -0,0 +1,189 @@
+#include <Arduino.h>
+
+#include "./Trajectory.h"
+
+// Converts to a fixed point number with fractionBits fractional bits. Saturates instead of overflowing,
+// which only happens far beyond any speed the steppers can run at
+static int64_t toFixed(const double value, const int fractionBits) {
+	const double scaled = ldexp(value, fractionBits);
+	if (scaled >= 9.2e18) {
+		return 9200000000000000000LL;
+	}
+	if (scaled <= -9.2e18) {
+		return -9200000000000000000LL;
+	}
+	return static_cast<int64_t>(scaled);
+}
+
+
+void Trajectory::sampleTimes(const double windowSeconds, double times[TRAJECTORY_SAMPLES]) {
+	for (int i = 0; i < TRAJECTORY_SAMPLES; i++) {
+		times[i] = windowSeconds * 0.5 * (1. - cos((2 * i + 1) * PI / (2 * TRAJECTORY_SAMPLES)));
+	}
+}
+
+
+/*
+ * Newton's divided differences give the polynomial as
+ * a0 + a1 (t - t0) + a2 (t - t0)(t - t1) + a3 (t - t0)(t - t1)(t - t2)
+ * which is then multiplied out from the innermost term, like Horner's method.
+ * The positions are made relative to a whole step first, so that 32 bit floats (AVR) keep the sub-step part
+ */
+void Trajectory::fit(const double times[TRAJECTORY_SAMPLES], const double positions[TRAJECTORY_SAMPLES]) {
+	const long base = static_cast<long>(floor(positions[0]));
+
+	double divided[TRAJECTORY_SAMPLES];
+	for (int i = 0; i < TRAJECTORY_SAMPLES; i++) {
+		divided[i] = positions[i] - base;
+	}
+	for (int order = 1; order < TRAJECTORY_SAMPLES; order++) {
+		for (int i = TRAJECTORY_SAMPLES - 1; i >= order; i--) {
+			divided[i] = (divided[i] - divided[i - 1]) / (times[i] - times[i - order]);
+		}
+	}
+
+	double coefficients[TRAJECTORY_SAMPLES] = { divided[TRAJECTORY_SAMPLES - 1], 0., 0., 0. };
+	for (int k = TRAJECTORY_SAMPLES - 2; k >= 0; k--) {
+		// coefficients = coefficients * (t - times[k]) + divided[k]
+		for (int i = TRAJECTORY_SAMPLES - 1; i > 0; i--) {
+			coefficients[i] = coefficients[i - 1] - times[k] * coefficients[i];
+		}
+		coefficients[0] = divided[k] - times[k] * coefficients[0];
+	}
+
+	_base = base;
+	for (int i = 0; i < TRAJECTORY_SAMPLES; i++) {
+		_coefficients[i] = coefficients[i];
+	}
+}
+
+
+// The Taylor series of a cubic at the start of the window. The position is made relative to a whole step, like in fit()
+void Trajectory::set(const double position, const double speed, const double acceleration, const double jerk) {
+	const long base = static_cast<long>(floor(position));
+	_base = base;
+	_coefficients[0] = position - base;
+	_coefficients[1] = speed;
+	_coefficients[2] = acceleration / 2.;
+	_coefficients[3] = jerk / 6.;
+}
+
+
+double Trajectory::positionAt(const double seconds) const {
+	const double* c = _coefficients;
+	return _base + (c[0] + seconds * (c[1] + seconds * (c[2] + seconds * c[3])));
+}
+
+
+/*
+ * The forward differences of the cubic at s with a tick length of h:
+ * first  = p(s + h) - p(s)                  = c1 h + c2 (2 s h + h^2) + c3 (3 s^2 h + 3 s h^2 + h^3)
+ * second = p(s + 2h) - 2 p(s + h) + p(s)    = 2 c2 h^2 + c3 (6 s h^2 + 6 h^3)
+ * third                                     = 6 c3 h^3
+ * They are calculated from the coefficients instead of by subtracting positions, which would cancel out all precision
+ */
+void Trajectory::start(const double seconds, const double tickSeconds, const double windowSeconds) {
+	const double* c = _coefficients;
+	const double s = seconds;
+	const double h = tickSeconds;
+
+	const double relative = c[0] + s * (c[1] + s * (c[2] + s * c[3]));
+	const double first = c[1] * h + c[2] * (2. * s * h + h * h) + c[3] * (3. * s * s * h + 3. * s * h * h + h * h * h);
+	const double second = 2. * c[2] * h * h + c[3] * (6. * s * h * h + 6. * h * h * h);
+	const double third = 6. * c[3] * h * h * h;
+
+	const int64_t position = static_cast<int64_t>(_base) * 4294967296LL + toFixed(relative, 32);
+	const unsigned long remainingTicks = windowSeconds > seconds ? static_cast<unsigned long>((windowSeconds - seconds) / h) : 0;
+
+	_position = position;
+	_first = toFixed(first, 48);
+	_second = toFixed(second, 64);
+	_third = toFixed(third, 64);
+	_remainingTicks = remainingTicks;
+}
+
+
+long Trajectory::nextTick() {
+	const long target = static_cast<long>(_position >> 32);
+
+	_position += _first >> 16;
+	if (_remainingTicks > 0) {
+		_first += _second >> 16;
+		_second += _third;
+		_remainingTicks--;
+	}
+
+	return target;
+}
+
+
+/*
+ * After k ticks, with s = second >> 16 and t = third >> 16 (both in the format of first):
+ * position += (k first + (k choose 2) s + (k choose 3) t) >> 16
+ * first    += k s + (k choose 2) t
+ * second   += k third
+ * With k <= MAX_ADVANCE_TICKS (2^10), (k choose 2) < 2^19 and (k choose 3) < 2^28. So the products stay below 2^63
+ * as long as the speed is below 2^5 steps per tick, the acceleration below 2^-4 steps per tick^2 and the jerk below
+ * 2^-13 steps per tick^3. That is far more than any stepper can do.
+ * Callers keep to that bound: The stepper interrupt runs at least every STEP_TIMER_MAX_MICROS, and Dobson::startSegment()
+ * limits how far a late segment skips ahead
+ */
+void Trajectory::advance(const unsigned long ticks) {
+	const unsigned long curved = ticks < _remainingTicks ? ticks : _remainingTicks;
+	if (curved > 0) {
+		const int64_t k = curved;
+		const int64_t pairs = k * (k - 1) / 2;
+		const int64_t triples = pairs * (k - 2) / 3;
+		const int64_t second = _second >> 16;
+		const int64_t third = _third >> 16;
+
+		_position += (k * _first + pairs * second + triples * third) >> 16;
+		_first += k * second + pairs * third;
+		_second += k * _third;
+		_remainingTicks -= curved;
+	}
+
+	// After the window, the speed stays constant
+	if (ticks > curved) {
+		_position += (static_cast<int64_t>(ticks - curved) * _first) >> 16;
+	}
+}
+
+
+long Trajectory::target() const {
+	return static_cast<long>(_position >> 32);
+}
+
+
+/*
+ * The distance to the next step is below one step (2^32), unless the axis is ahead of the trajectory.
+ * Then this waits maxTicks, as it does when the speed is 0. That keeps this to a 32 bit division.
+ * At more than a step per tick, the next step is always due in the next tick
+ */
+unsigned long Trajectory::ticksUntilStep(const long position, const unsigned long maxTicks) const {
+	const int64_t speed = _first >> 16;
+	int64_t distance;
+	if (speed > 0) {
+		distance = (static_cast<int64_t>(position) + 1) * 4294967296LL - _position;
+	}
+	else if (speed < 0) {
+		distance = _position - static_cast<int64_t>(position) * 4294967296LL + 1;
+	}
+	else {
+		return maxTicks;
+	}
+
+	if (distance <= 0) {
+		return 0;
+	}
+	const int64_t absoluteSpeed = speed > 0 ? speed : -speed;
+	if (absoluteSpeed > 0xFFFFFFFFLL) {
+		return 1;
+	}
+	if (distance > 0xFFFFFFFFLL) {
+		return maxTicks;
+	}
+
+	const unsigned long ticks = static_cast<uint32_t>(distance) / static_cast<uint32_t>(absoluteSpeed) + 1;
+	return ticks < maxTicks ? ticks : maxTicks;
+}
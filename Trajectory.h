@@ -0,0 +1,75 @@
+#pragma once
+/*
+ * Trajectory.h
+ *
+ * A cubic polynomial of the step position of one axis over a short time window.
+ * The mount fits it to a few exact positions of the target (which needs the trig functions), or sets it to one
+ * phase of a slew (see SlewPlanner.h), and the stepper interrupt then evaluates it every tick with forward differences: three 64 bit integer
+ * additions per tick, no multiplications and no floats.
+ *
+ * Fixed point formats of the forward differences (all int64_t):
+ *     position    Q32.32 steps
+ *     first       Q16.48 steps per tick
+ *     second      Q0.64 steps per tick^2
+ *     third       Q0.64 steps per tick^3
+ * The second and third differences are tiny at tracking speeds. They would vanish in the format of the position.
+ *
+ * When the stepper interrupt is only scheduled for the next step (STEP_GENERATOR), advance() skips several ticks at once
+ * and ticksUntilStep() estimates when the next step is due.
+ */
+
+#include <stdint.h>
+
+// Number of points the polynomial is fitted to
+#define TRAJECTORY_SAMPLES 4
+
+class Trajectory {
+public:
+	// Chebyshev nodes on [0, windowSeconds]. Fitting at these keeps the maximum interpolation error smallest
+	static void sampleTimes(const double windowSeconds, double times[TRAJECTORY_SAMPLES]);
+
+	// Fits the polynomial through the positions (in steps, not rounded) at the times (in seconds since the start of the window)
+	void fit(const double times[TRAJECTORY_SAMPLES], const double positions[TRAJECTORY_SAMPLES]);
+
+	// Sets the polynomial from the position (in steps, not rounded), speed (steps per second), acceleration (steps per second^2)
+	// and jerk (steps per second^3) at the start of the window
+	void set(const double position, const double speed, const double acceleration, const double jerk);
+
+	// Position in steps at seconds since the start of the window. For the main loop, this uses floats
+	double positionAt(const double seconds) const;
+
+	// Sets up the forward differences for the stepper interrupt, beginning seconds after the start of the window.
+	// nextTick() then advances by tickSeconds per call. After windowSeconds, it continues with a constant speed
+	void start(const double seconds, const double tickSeconds, const double windowSeconds);
+
+	// Called by the stepper interrupt once per tick. Returns the step position the axis should be at during this tick
+	long nextTick();
+
+	// Most ticks advance() can skip at once without overflowing its 64 bit products (see Trajectory.cpp)
+	static const unsigned long MAX_ADVANCE_TICKS = 1024;
+
+	// Same as calling nextTick() ticks times, but with a constant number of 64 bit multiplications (for the binomial coefficients).
+	// ticks must be at most MAX_ADVANCE_TICKS
+	void advance(const unsigned long ticks);
+
+	// The step position the axis should be at during the current tick
+	long target() const;
+
+	// Ticks until target() moves on from position by one step, from the current speed. At most maxTicks.
+	// This ignores the change of speed, which is negligible over maxTicks
+	unsigned long ticksUntilStep(const long position, const unsigned long maxTicks) const;
+
+protected:
+	// Polynomial relative to _base: positionAt(t) = _base + _coefficients[0] + _coefficients[1] * t + ...
+	long _base = 0;
+	double _coefficients[TRAJECTORY_SAMPLES] = { 0., 0., 0., 0. };
+
+	// Forward differences. Once the trajectory is queued (see MotionSegment in Mount.h), only the stepper interrupt touches them
+	int64_t _position = 0;
+	int64_t _first = 0;
+	int64_t _second = 0;
+	int64_t _third = 0;
+
+	// Ticks until the end of the window
+	unsigned long _remainingTicks = 0;
+};
@@ -0,0 +1,213 @@
+#include <Arduino.h>
+
+#include "./TrigTables.h"
+
+static_assert((TRIG_TABLE_SIZE & (TRIG_TABLE_SIZE - 1)) == 0, "TRIG_TABLE_SIZE must be a power of two");
+
+
+/*
+ * Compile time math
+ * C++11 constexpr functions can only consist of a single return statement, so the series are recursive.
+ * They are only evaluated by the compiler, never at runtime.
+ */
+
+// Taylor series of sin(x) for 0 <= x <= pi / 2. The 12th term is below 1e-15
+constexpr double sineSeries(const double x2, const double term, const double sum, const int n) {
+	return n > 12 ? sum : sineSeries(x2, -term * x2 / ((2. * n) * (2. * n + 1.)), sum + term, n + 1);
+}
+
+constexpr double constexprSin(const double x) {
+	return sineSeries(x * x, x, 0., 1);
+}
+
+// Newton's method. Only used for 1 <= x <= 2, where 8 iterations are plenty
+constexpr double sqrtNewton(const double x, const double guess, const int iterations) {
+	return iterations == 0 ? guess : sqrtNewton(x, 0.5 * (guess + x / guess), iterations - 1);
+}
+
+constexpr double constexprSqrt(const double x) {
+	return sqrtNewton(x, x, 8);
+}
+
+// Taylor series of atan(x), which only converges quickly for small x
+constexpr double atanSeries(const double x2, const double power, const double sum, const int n) {
+	return n > 20 ? sum : atanSeries(x2, -power * x2, sum + power / (2. * n + 1.), n + 1);
+}
+
+// atan(x) = 2 * atan(x / (1 + sqrt(1 + x^2))). Halving twice gets 0 <= x <= 1 below tan(pi / 16) = 0.2
+constexpr double halveAtanArgument(const double x) {
+	return x / (1. + constexprSqrt(1. + x * x));
+}
+
+constexpr double quarterAtan(const double quarterArgument) {
+	return atanSeries(quarterArgument * quarterArgument, quarterArgument, 0., 0);
+}
+
+constexpr double constexprAtan(const double x) {
+	return 4. * quarterAtan(halveAtanArgument(halveAtanArgument(x)));
+}
+
+
+/*
+ * Generating the tables
+ * MakeIndexSequence<N>::type is IndexSequence<0, 1, ..., N - 1> (std::make_index_sequence is C++14).
+ * It splits N in halves, so that the template recursion depth is only log2(N)
+ */
+template<unsigned int... I>
+struct IndexSequence {};
+
+template<typename First, typename Second>
+struct ConcatenateSequences;
+
+template<unsigned int... First, unsigned int... Second>
+struct ConcatenateSequences<IndexSequence<First...>, IndexSequence<Second...>> {
+	typedef IndexSequence<First..., (sizeof...(First) + Second)...> type;
+};
+
+template<unsigned int N>
+struct MakeIndexSequence {
+	typedef typename ConcatenateSequences<typename MakeIndexSequence<N / 2>::type, typename MakeIndexSequence<N - N / 2>::type>::type type;
+};
+
+template<>
+struct MakeIndexSequence<0> {
+	typedef IndexSequence<> type;
+};
+
+template<>
+struct MakeIndexSequence<1> {
+	typedef IndexSequence<0> type;
+};
+
+// sin(i * (pi / 2) / TRIG_TABLE_SIZE)
+template<typename Sequence>
+struct SineTable;
+
+template<unsigned int... I>
+struct SineTable<IndexSequence<I...>> {
+	static const float values[sizeof...(I)];
+};
+
+template<unsigned int... I>
+const float SineTable<IndexSequence<I...>>::values[sizeof...(I)] PROGMEM = {
+	static_cast<float>(constexprSin(I * (HALF_PI / TRIG_TABLE_SIZE)))...
+};
+
+// atan(i / TRIG_TABLE_SIZE)
+template<typename Sequence>
+struct ArctangentTable;
+
+template<unsigned int... I>
+struct ArctangentTable<IndexSequence<I...>> {
+	static const float values[sizeof...(I)];
+};
+
+template<unsigned int... I>
+const float ArctangentTable<IndexSequence<I...>>::values[sizeof...(I)] PROGMEM = {
+	static_cast<float>(constexprAtan(I / static_cast<double>(TRIG_TABLE_SIZE)))...
+};
+
+typedef SineTable<MakeIndexSequence<TRIG_TABLE_SIZE + 1>::type> QuarterSine;
+typedef ArctangentTable<MakeIndexSequence<TRIG_TABLE_SIZE + 1>::type> Arctangent;
+
+
+/*
+ * Lookups
+ */
+
+// Table intervals per radian
+const float SINE_TABLE_SCALE = static_cast<float>(TRIG_TABLE_SIZE / HALF_PI);
+
+/*
+ * index counts table intervals from 0, with 4 * TRIG_TABLE_SIZE per revolution. Unsigned overflow
+ * of negative angles is harmless, because the revolution is a power of two.
+ * The quadrant picks the direction through the quarter wave table and the sign
+ */
+static float sineOfIndex(const unsigned long index, const float fraction) {
+	const unsigned int quadrant = (index / TRIG_TABLE_SIZE) & 3;
+	const unsigned int i = index % TRIG_TABLE_SIZE;
+
+	float from;
+	float to;
+	if (quadrant & 1) {
+		from = pgm_read_float(&QuarterSine::values[TRIG_TABLE_SIZE - i]);
+		to = pgm_read_float(&QuarterSine::values[TRIG_TABLE_SIZE - i - 1]);
+	}
+	else {
+		from = pgm_read_float(&QuarterSine::values[i]);
+		to = pgm_read_float(&QuarterSine::values[i + 1]);
+	}
+
+	const float value = from + fraction * (to - from);
+	return (quadrant & 2) ? -value : value;
+}
+
+// Splits x into whole table intervals (rounded towards negative infinity) and the fraction of the next one
+static void sineTablePosition(const float x, long& index, float& fraction) {
+	const float position = x * SINE_TABLE_SCALE;
+	index = static_cast<long>(position);
+	if (position < index) {
+		index--;
+	}
+	fraction = position - index;
+}
+
+
+float tableSin(const float x) {
+	long index;
+	float fraction;
+	sineTablePosition(x, index, fraction);
+	return sineOfIndex(static_cast<unsigned long>(index), fraction);
+}
+
+
+// cos(x) = sin(x + pi / 2), which is exactly one quadrant further in the table
+float tableCos(const float x) {
+	long index;
+	float fraction;
+	sineTablePosition(x, index, fraction);
+	return sineOfIndex(static_cast<unsigned long>(index) + TRIG_TABLE_SIZE, fraction);
+}
+
+
+// atan(ratio) for 0 <= ratio <= 1
+static float arctangentOfRatio(const float ratio) {
+	const float position = ratio * TRIG_TABLE_SIZE;
+	unsigned int i = static_cast<unsigned int>(position);
+	if (i >= TRIG_TABLE_SIZE) {
+		i = TRIG_TABLE_SIZE - 1;
+	}
+	const float fraction = position - i;
+
+	const float from = pgm_read_float(&Arctangent::values[i]);
+	const float to = pgm_read_float(&Arctangent::values[i + 1]);
+	return from + fraction * (to - from);
+}
+
+
+/*
+ * Reduces the angle to the first octant, where the ratio of the smaller and the larger coordinate is <= 1.
+ * This costs a single division
+ */
+float tableAtan2(const float y, const float x) {
+	const float absX = fabsf(x);
+	const float absY = fabsf(y);
+	if (absX == 0.f && absY == 0.f) {
+		return 0.f;
+	}
+
+	float angle = absY <= absX
+		? arctangentOfRatio(absY / absX)
+		: static_cast<float>(HALF_PI) - arctangentOfRatio(absX / absY);
+
+	if (x < 0.f) {
+		angle = static_cast<float>(PI) - angle;
+	}
+	return y < 0.f ? -angle : angle;
+}
+
+
+float tableAsin(const float x) {
+	const float value = constrain(x, -1.f, 1.f);
+	return tableAtan2(value, sqrtf(1.f - value * value));
+}
@@ -0,0 +1,36 @@
+#pragma once
+/*
+ * TrigTables.h
+ *
+ * sin, cos, atan2 and asin for float, using linear interpolation in lookup tables instead of libm.
+ * On the AVR, libm's sinf() and atan2f() take well over a thousand cycles each. A table lookup is two
+ * flash reads and a few float operations.
+ *
+ * The tables are computed by the compiler (see TrigTables.cpp) and live in flash (PROGMEM).
+ * Each table has TRIG_TABLE_SIZE + 1 float entries, 4 KB each for the sine and arctangent tables.
+ *
+ * Maximum absolute error (measured by dobson_bench, "accuracy/trig" report):
+ *     tableSin, tableCos    9.1e-7 rad (0.19 arcseconds) for |x| < 4 pi. Larger arguments lose float precision
+ *     tableAtan2            3.5e-7 rad (0.07 arcseconds)
+ *     tableAsin             7.9e-7 rad (0.16 arcseconds) for |x| < 0.9999. Towards +-1 the error grows,
+ *                           because asin() itself is ill-conditioned there
+ * One step of the axes is about 10 arcseconds with the example gear ratios in config.h.
+ * The interpolation error shrinks with the square of TRIG_TABLE_SIZE.
+ *
+ * Use them through LookupTablePolicy (see NumericPolicy.h and COORDINATE_NUMERIC_POLICY in config.h).
+ */
+
+// Number of interpolation intervals per quarter wave (sine) and on [0, 1] (arctangent). Must be a power of two
+#define TRIG_TABLE_SIZE 1024
+
+// x in radians
+float tableSin(const float x);
+
+// x in radians
+float tableCos(const float x);
+
+// Angle of (x, y) in radians, -pi <= result <= pi. Returns 0 for (0, 0)
+float tableAtan2(const float y, const float x);
+
+// Result in radians. x is constrained to -1 <= x <= 1
+float tableAsin(const float x);
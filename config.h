@@ -9,6 +9,14 @@
 
 // Baudrate to use when communicating over serial connection
 #define SERIAL_BAUDRATE 56000
+// Received commands waiting to be run. Each loop iteration reads everything the serial port has buffered, so a burst
+// like ":Sr..#:Sd..#:MS#" from Stellarium is queued at once. Must be a power of two. A command takes 32 bytes of RAM
+#define SERIAL_COMMAND_QUEUE_LENGTH 8
+// Output buffers of the serial port in bytes (see SerialOutput.h). Both must be powers of two
+// Replies to commands. Text that does not fit waits for the serial port, like it would without the buffer
+#define SERIAL_REPLY_BUFFER_SIZE 128
+// Debug messages. Lines that do not fit are dropped
+#define SERIAL_DEBUG_BUFFER_SIZE 256
 
 /*
  * Mount type
@@ -42,9 +50,15 @@
 #define AZ_ENABLE_PIN       38     // RAMPS 1.4 X stepper
 #define AZ_STEP_PIN         54     // RAMPS 1.4
 #define AZ_DIR_PIN          55     // RAMPS 1.4
+#ifndef AZ_STEPS_PER_REV // The host build (CMakeLists.txt) sets this on the command line
 #define AZ_STEPS_PER_REV     0.    // My value: 119467.0  // How many steps the stepper motor needs to complete for one a horizontal 360degree revolution of the telescope (my setup: 3200 : 1 and 560 : 15)
+#endif
 #define AZ_MAX_ACCEL        300    // Maximum acceleration for the azimuth stepper
 #define AZ_MAX_SPEED       4000    // Maximum speed for the azimuth stepper
+// How far (in degrees) the azimuth axis may turn away from where it was homed or aligned, in either direction, before the cables wind up too far.
+// The azimuth steps are continuous (crossing north does not jump by a revolution), and a GoTo takes the faster way around unless that passes this limit.
+// Must be at least 180. Comment out for no limit
+#define AZ_CABLE_WRAP_DEG   270
 
 /*
  * Altitude stepper
@@ -55,7 +69,9 @@
 #define ALT_ENABLE_PIN       56     // RAMPS 1.4 Y stepper
 #define ALT_STEP_PIN         60     // RAMPS 1.4
 #define ALT_DIR_PIN          61     // RAMPS 1.4
+#ifndef ALT_STEPS_PER_REV // The host build (CMakeLists.txt) sets this on the command line
 #define ALT_STEPS_PER_REV     0.    // How many steps the stepper motor needs to complete for a vertical 360degree revolution of the telescope (my setup: 5.18:1 and 3200 : 1 and 105 : 12 = 147840.0)
+#endif
 #define ALT_MAX_ACCEL         400   // Maximum acceleration for the altitude stepper
 #define ALT_MAX_SPEED        10000  // Maximum speed for the altitude stepper
 
@@ -179,10 +195,44 @@
  *
  * -------------------
  */
-// Update the motor positions (e.g. call Mount::calculateMotorTargets()) every X ms
+// Update the motor positions (e.g. call Mount::calculateMotorTargets()) every X ms while the steppers move to a target or slew,
+// and while tracking with TRACKING_VELOCITY_FEED_FORWARD
 #define UPDATE_MOTOR_POS_MS 100
-// The stepper interrupts get called every STEPPER_INTERRUPT_FREQ microseconds.
+// Otherwise the Dobson mount updates them when the target has moved by one step on either axis, or when the next trajectory
+// is due (see Dobson::microsUntilUpdate()). Near the pole that is rarely, near the zenith often. A new target, alignment
+// or observer position is updated right away. These limit the time between two updates (in ms)
+#define UPDATE_MOTOR_POS_MIN_MS 10
+#define UPDATE_MOTOR_POS_MAX_MS 5000
+
+// How the Dobson mount tracks, once the steppers have arrived at the target. Enable at most one of these.
+// Without either, the steppers move to a new target position every UPDATE_MOTOR_POS_MS (which makes the motors accelerate, stop and wait)
+//
+// Velocity feed-forward: The steppers run continuously at the angular rate of the target, plus a correction of the remaining position error.
+// This also works with much longer update intervals, e.g. 1000ms
+//#define TRACKING_VELOCITY_FEED_FORWARD
+// Share of the remaining position error that is corrected per second. Keep this below 1000 / UPDATE_MOTOR_POS_MS
+#define TRACKING_CORRECTION_GAIN 0.5
+//
+// Trajectory: The mount fits a cubic polynomial to the step positions of the target over the next TRAJECTORY_WINDOW_MS.
+// The stepper interrupt evaluates it every tick with integer math, so each step happens in the tick it is due,
+// and the conversion of the target only runs once per TRAJECTORY_REFIT_MS (see Trajectory.h)
+#define TRACKING_TRAJECTORY
+#define TRAJECTORY_WINDOW_MS 4000
+#define TRAJECTORY_REFIT_MS  2000
+//
+// Position errors larger than this (in degrees, e.g. after selecting a new target) are corrected by moving to the target with acceleration
+#define TRACKING_MAX_ERROR 0.25
+
+// Slews (GoTo) of the Dobson mount to targets further away than TRACKING_MAX_ERROR
+// With SLEW_PLANNER, both axes follow one jerk-limited (S-curve) profile within AZ_MAX_SPEED / ALT_MAX_SPEED and AZ_MAX_ACCEL / ALT_MAX_ACCEL,
+// so that they start and arrive together (see SlewPlanner.h). The stepper interrupt follows it like a trajectory.
+// Without it, each stepper accelerates and decelerates on its own and the axes arrive at different times
+#define SLEW_PLANNER
+// Time (in ms) it takes to build up to the maximum acceleration. Longer is gentler on the mount, but makes slews slower
+#define SLEW_JERK_MS 250
+// Without STEP_GENERATOR, the stepper interrupts get called every STEPPER_INTERRUPT_FREQ microseconds.
 // 1.000.000 means the interrupt gets called every second. 1.000 means every ms
+// With STEP_GENERATOR, this is the time step of the trajectories (TRACKING_TRAJECTORY, SLEW_PLANNER)
 // The values below are reasonable for the default motor speeds and the respective boards
 #ifdef BOARD_ARDUINO_MEGA
 #define STEPPER_INTERRUPT_FREQ 500 // every 0.5ms
@@ -191,6 +241,44 @@
 #define STEPPER_INTERRUPT_FREQ 100 // every 0.1ms
 #endif
 
+// Step generation in the stepper interrupt
+// With STEP_GENERATOR, the steppers are driven by StepGenerator (see StepGenerator.h). The stepper interrupt is scheduled for the next step
+// of either stepper, instead of running every STEPPER_INTERRUPT_FREQ microseconds. The speed ramps use integer math only.
+// Without it, the AccelStepper library is used. The steppers then make at most one step per interrupt, so speeds above 1.000.000 / STEPPER_INTERRUPT_FREQ have no effect
+#define STEP_GENERATOR
+//
+// Shortest time between two stepper interrupts (in microseconds). This must be longer than the interrupt takes (see :DBGISR#)
+// It limits the number of steps per second of both steppers together
+#ifdef BOARD_ARDUINO_MEGA
+#define STEP_TIMER_MIN_MICROS 150
+#endif
+#ifdef BOARD_ARDUINO_DUE
+#define STEP_TIMER_MIN_MICROS 25
+#endif
+// Longest time between two stepper interrupts (in microseconds). New targets and speeds take effect within this time
+// The Mega's 16 bit timer can not wait longer than 32767
+#define STEP_TIMER_MAX_MICROS 10000
+
+// Motion queue between the main loop and the stepper interrupt (see MotionSegment in Mount.h)
+// The main loop does not change the steppers itself. It queues segments (a target position, a speed or a trajectory),
+// which the stepper interrupt starts at their start time. Must be a power of two. A segment takes about 140 bytes of RAM on the Mega
+#define MOTION_QUEUE_LENGTH 4
+// While tracking along trajectories, the next trajectory is queued this many ms before the queued ones run out
+#define MOTION_QUEUE_AHEAD_MS 500
+
+// Number format of the coordinate conversion and the conversion between degrees and steps (see NumericPolicy.h)
+// Float32Policy: float everywhere. On the Mega double is a 32 bit float anyway
+// LookupTablePolicy: float, with interpolated sin/cos/atan2 tables in flash instead of libm (see TrigTables.h). Uses 8 KB flash
+// Float64Policy: double everywhere. The most precise, but on the Due double is a slow 64 bit soft-float
+// FixedPointPolicy: float for the trig functions, 64 bit integer math for the conversion to steps
+// The host benchmark (dobson_bench, see README.md) reports the speed and the accuracy of each policy
+#ifdef BOARD_ARDUINO_MEGA
+#define COORDINATE_NUMERIC_POLICY LookupTablePolicy
+#endif
+#ifdef BOARD_ARDUINO_DUE
+#define COORDINATE_NUMERIC_POLICY FixedPointPolicy
+#endif
+
 
 
 
@@ -222,55 +310,58 @@ static constexpr cstr past_last_slash(cstr str)
 // The filename part of __FILE__ excluding the path
 #define __FILENAME__ ({constexpr cstr sf__ {past_last_slash(__FILE__)}; sf__;})
 
+// Debug messages go through their own output buffer, so they do not delay replies to commands
+#include "./SerialOutput.h"
+
 // Prints a debug message
-#define DEBUG_PRINT(x)    Serial.print(x)
+#define DEBUG_PRINT(x)    SerialDebug.print(x)
 
 // Prints a debug message line
-#define DEBUG_PRINTLN(x)  Serial.println(x)
+#define DEBUG_PRINTLN(x)  SerialDebug.println(x)
 
 // Prints a debug message with time, file name and line number
 #define DEBUG_PRINT_V(x)   \
-		   Serial.print(String(millis() / 1000., 2)); \
-		   Serial.print(": ");       \
-		   Serial.print(__FILENAME__);\
-		   Serial.print(':');          \
-		   Serial.print(__LINE__);      \
-		   Serial.print(' ');            \
-		   Serial.print(x);
+		   SerialDebug.print(String(millis() / 1000., 2)); \
+		   SerialDebug.print(": ");       \
+		   SerialDebug.print(__FILENAME__);\
+		   SerialDebug.print(':');          \
+		   SerialDebug.print(__LINE__);      \
+		   SerialDebug.print(' ');            \
+		   SerialDebug.print(x);
 
 // Prints a debug message line with timestamp, file name and line number
 #define DEBUG_PRINTLN_V(x)   \
-		   Serial.print(String(millis() / 1000., 2)); \
-		   Serial.print(": ");       \
-		   Serial.print(__FILENAME__);\
-		   Serial.print(':');          \
-		   Serial.print(__LINE__);      \
-		   Serial.print(' ');            \
-		   Serial.println(x);
+		   SerialDebug.print(String(millis() / 1000., 2)); \
+		   SerialDebug.print(": ");       \
+		   SerialDebug.print(__FILENAME__);\
+		   SerialDebug.print(':');          \
+		   SerialDebug.print(__LINE__);      \
+		   SerialDebug.print(' ');            \
+		   SerialDebug.println(x);
 
 // Prints a debug message with timestamp, function name, file name and line number
 #define DEBUG_PRINT_VV(x)   \
-		   Serial.print(String(millis() / 1000., 2)); \
-		   Serial.print(": ");     \
-		   Serial.print(__PRETTY_FUNCTION__); \
-		   Serial.print(' ');        \
-		   Serial.print(__FILENAME__);\
-		   Serial.print(':');          \
-		   Serial.print(__LINE__);      \
-		   Serial.print(' ');            \
-		   Serial.print(x);
+		   SerialDebug.print(String(millis() / 1000., 2)); \
+		   SerialDebug.print(": ");     \
+		   SerialDebug.print(__PRETTY_FUNCTION__); \
+		   SerialDebug.print(' ');        \
+		   SerialDebug.print(__FILENAME__);\
+		   SerialDebug.print(':');          \
+		   SerialDebug.print(__LINE__);      \
+		   SerialDebug.print(' ');            \
+		   SerialDebug.print(x);
 
 // Prints a debug message line with timestamp, function name, file name and line number
 #define DEBUG_PRINTLN_VV(x) \
-		   Serial.print(String(millis() / 1000., 2)); \
-		   Serial.print(": ");     \
-		   Serial.print(__PRETTY_FUNCTION__); \
-		   Serial.print(' ');        \
-		   Serial.print(__FILENAME__);\
-		   Serial.print(':');          \
-		   Serial.print(__LINE__);      \
-		   Serial.print(' ');            \
-		   Serial.println(x);
+		   SerialDebug.print(String(millis() / 1000., 2)); \
+		   SerialDebug.print(": ");     \
+		   SerialDebug.print(__PRETTY_FUNCTION__); \
+		   SerialDebug.print(' ');        \
+		   SerialDebug.print(__FILENAME__);\
+		   SerialDebug.print(':');          \
+		   SerialDebug.print(__LINE__);      \
+		   SerialDebug.print(' ');            \
+		   SerialDebug.println(x);
 #else
 // (Disabled) Prints a debug message. Define the DEBUGand DEBUG_SERIAL constants to enable
 #define DEBUG_PRINT(x)
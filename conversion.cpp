@@ -13,6 +13,12 @@
 #include "./conversion.h"
 #include "./Observer.h"
 #include "./location.h"
+#include "./Profiler.h"
+#include "./RingBuffer.h"
+#include "./SerialOutput.h"
+#include "./StepGenerator.h"
+#include "./Telemetry.h"
+#include "./TimedActions.h"
 
 #ifdef SERIAL_DISPLAY_ENABLED
 	#include "./display_unit.h"
@@ -35,12 +41,30 @@ boolean isPositiveDeclination = false;
 boolean isAligned = false;
 
 char txAR[10]; // Gets reported to stellarium when it asks for right ascension. Example: "16:41:34#"
-char txDEC[11]; // Same as above with declination. Example: "+36d%c28:%02d#"
+char txDEC[11]; // Same as above with declination. Example: "+3628:12#"
+
+/*
+ * Stellarium polls :GR# and :GD# several times a second, but the position only changes with the motor updates.
+ * So txAR and txDEC are only formatted again when the position differs from the one they were formatted for
+ * (or the precision changed). Otherwise the replies are sent as they are.
+ * :U# switches between the LX200 high precision (HH:MM:SS# and sDDMM:SS#) and low precision (HH:MM.T# and sDDMM#) formats
+ */
+static boolean highPrecision = true;
+static boolean txARValid = false;
+static boolean txDECValid = false;
+static double txARPosition; // Right ascension in txAR
+static double txDECPosition; // Declination in txDEC
 
 const byte numChars = 32;
-char receivedChars[numChars];
+char receivedChars[numChars]; // The command currently being received
+
+// A complete command without its start and end markers
+struct ReceivedCommand {
+	char text[numChars];
+};
+// Complete commands in the order they were received, waiting for parseCommands()
+static RingBuffer<ReceivedCommand, SERIAL_COMMAND_QUEUE_LENGTH> receivedCommands;
 
-bool newData = false; // Gets set to true whenever a complete command is buffered
 static boolean recvInProgress = false; // True while a command is being received
 static byte ndx = 0; // Number of command character received
 const char startMarker = ':'; // Commands begin with this character
@@ -102,6 +126,22 @@ unsigned long timeOfLastTargetChange = 0;
 void getRightAscension(Mount& scope);
 void getDeclination(Mount& scope);
 
+// Ends the pause of the stepper drivers started by :DBGDM##. setSteppersOnOffState() then turns them on again
+void resumeMotors() {
+	SerialReplies.println("Continuing");
+}
+
+bool steppersPaused() {
+	return TimedActions::isPending(&resumeMotors);
+}
+
+#if defined TARGET_SELECT_PIN && defined BUZZER_PIN
+	// Ends the beep of the target select button
+	void buzzerOff() {
+		FastPin<BUZZER_PIN>::write(LOW);
+	}
+#endif
+
 // This gets called by the Arduino setup() function and sends the initial position to Stellarium
 void initCommunication(Mount& telescope) {
 	getRightAscension(telescope);
@@ -109,17 +149,18 @@ void initCommunication(Mount& telescope) {
 }
 
 /*
- * Every loop iteration this function checks if a new character is available from the Serial interface. It only reads the
- * character if the variable newData is set to false. It then tries to read a complete command (1 char per loop iteration).
- * When a command is complete, this function sets newData to true. Later on in the loop iteration the parseCommands function,
- * which tries to parse and execute the command, gets called. After command execution the newData variable is reset to false
+ * Every loop iteration this function reads all characters that the Serial interface has buffered. Characters between
+ * the start and end markers are collected in receivedChars. Once the end marker arrives, the complete command is queued
+ * in receivedCommands and the next command can start right away, so several commands can arrive within one iteration.
+ * Later on in the loop iteration the parseCommands function runs the queued commands.
+ * If the queue is full, the remaining characters stay in the Serial buffer until the queued commands were run
  */
-void receiveCommandChar() {
-	if (Serial.available() > 0 && newData == false) {
+void receiveCommands() {
+	while (Serial.available() > 0 && !receivedCommands.isFull()) {
 		// Read the next character
 		char rc = Serial.read();
 
-		// Here we check if the command start marker has already been read in a previous loop iteration.
+		// Here we check if the command start marker has already been read
 		if (recvInProgress == true) {
 			// If the character is NOT the end marker, we treat it as part of the command, regardless of what it is
 			if (rc != endMarker) {
@@ -136,13 +177,14 @@ void receiveCommandChar() {
 				receivedChars[ndx] = '\0';
 				// Set recvInProgress to false, so that next time a character is received we check for the start marker again
 				recvInProgress = false;
-				// Reset ndx to 0 so that next time we read a command it gets stored at the start of the receivedChars array again
+				// Queue a copy for parseCommands. Reset ndx to 0 so that the next command gets stored at the start of receivedChars
+				ReceivedCommand command;
+				memcpy(command.text, receivedChars, ndx + 1);
+				receivedCommands.push(command);
 				ndx = 0;
-				// This signals to the parseCommands function that a complete command is now stored in receivedChars.
-				newData = true;
 			}
 		} else if (rc == startMarker) {
-			// Start marker received. Set recvInProgress to false, so that next time we check for the end marker or a command character
+			// Start marker received. Set recvInProgress to true, so that next time we check for the end marker or a command character
 			recvInProgress = true;
 		}
 	}
@@ -150,18 +192,6 @@ void receiveCommandChar() {
 
 
 
-// These will eventually be placeholders for a better looking command parser. Currently these do nothing
-#define SERIAL_CMD_INVALID_COMMAND     -1
-#define SERIAL_CMD_GET_RIGHT_ASCENSION 0
-#define SERIAL_CMD_GET_DECLINATION     1
-#define SERIAL_CMD_MOVE_STOP           2
-#define SERIAL_CMD_MOVE_START          3
-#define SERIAL_CMD_SET_RIGHT_ASCENSION 4
-#define SERIAL_CMD_SET_DECLINATION     5
-
-
-
-
 /**
  * Serial commands start
  * This section contains a function for each serial command that can get handled
@@ -169,49 +199,117 @@ void receiveCommandChar() {
  */
 // Print the possible commands
 void printHelp() {
-	Serial.println(":HLP# Print available Commands");
-	Serial.println(":GR# Get Right Ascension");
-	Serial.println(":GD# Get Declination");
-	Serial.println(":Sr,HH:MM:SS# Set Right Ascension; Example: :Sr,12:34:56#");
-	Serial.println(":Sd,[+/-]DD:MM:SS# Set Declination (DD is degrees) Example: :Sd,+12:34:56#");
-	Serial.println(":MS# Start Move; Starts tracking mode if not enabled");
-	Serial.println(":TRK0# Disable tracking");
-	Serial.println(":TRK1# Enable tracking");
-	Serial.print(":DBGM[0-" + String(maxDebugPos - 1) + "]# Move to debug position X");
-	Serial.println(":DBGMIA# Increase Ascension by 1 degree");
-	Serial.println(":DBGMDA# Decrease Ascension by 1 degree");
-	Serial.println(":DBGMID# Increase Declination by 1 degree");
-	Serial.println(":DBGMDD# Decrease Declination by 1 degree");
-	Serial.println(":DBGDM[00-99]# Disable Motors for XX seconds");
-	Serial.println(":DBGDSP# Send status update to display / serial console");
+	SerialReplies.println(":HLP# Print available Commands");
+	SerialReplies.println(":GR# Get Right Ascension");
+	SerialReplies.println(":GD# Get Declination");
+	SerialReplies.println(":U# Switch between high (HH:MM:SS, sDD*MM:SS) and low (HH:MM.T, sDD*MM) precision of :GR# and :GD#");
+	SerialReplies.println(":Sr,HH:MM:SS# Set Right Ascension; Example: :Sr,12:34:56#");
+	SerialReplies.println(":Sd,[+/-]DD:MM:SS# Set Declination (DD is degrees) Example: :Sd,+12:34:56#");
+	SerialReplies.println(":MS# Start Move; Starts tracking mode if not enabled");
+	SerialReplies.println(":TRK0# Disable tracking");
+	SerialReplies.println(":TRK1# Enable tracking");
+	SerialReplies.print(":DBGM[0-" + String(maxDebugPos - 1) + "]# Move to debug position X");
+	SerialReplies.println(":DBGMIA# Increase Ascension by 1 degree");
+	SerialReplies.println(":DBGMDA# Decrease Ascension by 1 degree");
+	SerialReplies.println(":DBGMID# Increase Declination by 1 degree");
+	SerialReplies.println(":DBGMDD# Decrease Declination by 1 degree");
+	SerialReplies.println(":DBGDM[00-99]# Disable Motors for XX seconds");
+	SerialReplies.println(":DBGDSP# Send status update to display / serial console");
+	SerialReplies.println(":DBGISR# Print and reset the longest stepper interrupt duration");
+	SerialReplies.println(":PERF# Print loop, stepper interrupt and task timing");
+	SerialReplies.println(":PERFRST# Reset the timing counters of :PERF#");
+	SerialReplies.println(":TLM[0-50]# Stream binary telemetry frames at X Hz; 0 stops the stream");
 }
 
 
 
+// Writes value (0 - 99) as two digits and returns the position after them
+static char* formatTwoDigits(char* text, const uint8_t value) {
+	text[0] = '0' + value / 10;
+	text[1] = '0' + value % 10;
+	return text + 2;
+}
+
 // Reports the current right ascension
 void getRightAscension(Mount& scope) {
-	const double pos = scope.getCurrentPosition().rightAscension / 15;
+	const double pos = scope.getCurrentPosition().rightAscension;
 
-	const int hrs = static_cast<int>(pos);
-	const int mins = static_cast<int>((pos - hrs) * 60);
-	const int secs = static_cast<int>((pos - (hrs + mins / 60.)) * 3600);
+	if (!txARValid || pos != txARPosition) {
+		txARPosition = pos;
+		txARValid = true;
+
+		double degrees = fmod(pos, 360.);
+		if (degrees < 0) {
+			degrees += 360.;
+		}
 
-	sprintf(txAR, "%02d:%02d:%02d#", hrs, mins, secs);
+		// One hour of right ascension is 15 degrees, so a degree is 4 minutes or 240 seconds. The rest is integer math
+		char* text = txAR;
+		if (highPrecision) {
+			const unsigned long seconds = static_cast<unsigned long>(degrees * 240. + 0.5) % (24UL * 3600);
+			text = formatTwoDigits(text, seconds / 3600);
+			*text++ = ':';
+			text = formatTwoDigits(text, seconds / 60 % 60);
+			*text++ = ':';
+			text = formatTwoDigits(text, seconds % 60);
+		}
+		else {
+			const unsigned long tenthMinutes = static_cast<unsigned long>(degrees * 40. + 0.5) % (24UL * 600);
+			text = formatTwoDigits(text, tenthMinutes / 600);
+			*text++ = ':';
+			text = formatTwoDigits(text, tenthMinutes / 10 % 60);
+			*text++ = '.';
+			*text++ = '0' + tenthMinutes % 10;
+		}
+		*text++ = '#';
+		*text = '\0';
+	}
 
-	Serial.print(txAR);
+	SerialReplies.print(txAR);
 }
 
 // Reports the current declination
 void getDeclination(Mount &scope) {
 	const double pos = scope.getCurrentPosition().declination;
 
-	const int deg = static_cast<int>(pos);
-	const int mins = static_cast<int>((pos - deg) * 60);
-	const int secs = static_cast<int>((pos - (deg + mins / 60.)) * 3600);
+	if (!txDECValid || pos != txDECPosition) {
+		txDECPosition = pos;
+		txDECValid = true;
+
+		// The sign is taken from the position itself, so that declinations between -1 and 0 are negative as well
+		double degrees = pos < 0 ? -pos : pos;
+		if (degrees > 90.) {
+			degrees = 90.;
+		}
+
+		char* text = txDEC;
+		*text++ = pos < 0 ? '-' : '+';
+		if (highPrecision) {
+			const unsigned long seconds = static_cast<unsigned long>(degrees * 3600. + 0.5);
+			text = formatTwoDigits(text, seconds / 3600);
+			*text++ = static_cast<char>(223);
+			text = formatTwoDigits(text, seconds / 60 % 60);
+			*text++ = ':';
+			text = formatTwoDigits(text, seconds % 60);
+		}
+		else {
+			const unsigned long minutes = static_cast<unsigned long>(degrees * 60. + 0.5);
+			text = formatTwoDigits(text, minutes / 60);
+			*text++ = static_cast<char>(223);
+			text = formatTwoDigits(text, minutes % 60);
+		}
+		*text++ = '#';
+		*text = '\0';
+	}
 
-	sprintf(txDEC, "%c%02d%c%02d:%02d#", deg > 0 ? '+' : '-', deg, 223, mins, secs);
+	SerialReplies.print(txDEC);
+}
 
-	Serial.print(txDEC);
+// Switches between the high and low precision format of :GR# and :GD#
+void togglePrecision() {
+	highPrecision = !highPrecision;
+	txARValid = false;
+	txDECValid = false;
 }
 
 // Quit the current move by setting the target to the current position.
@@ -224,7 +322,7 @@ void moveQuit(Mount& scope) {
 // Start the requested move
 bool moveStart(Mount& scope) {
 	// Immediately confirm to Stellarium
-	Serial.print("0");
+	SerialReplies.print("0");
 
 	// TODO Homing code needs to be better. It has to disable the steppers and there must be some way to enable/disable it
 	// If homing mode is true we set isAligned to true
@@ -247,14 +345,19 @@ bool moveStart(Mount& scope) {
 
 // Set Right Ascension (in hours, minutes and seconds)
 // This doesn't yet set it on the telescope (happens in moveStart())
-void setRightAscension(Mount &telescope) {
-	// Immediately confirm to Stellarium
-	Serial.print("1");
-
+// arguments is ",HH:MM:SS" (see the command table below). Out of range values are rejected with "0". Returns false then
+bool setRightAscension(Mount &telescope, const char* arguments) {
 	// Parse the coordinates part of the command to integers
-	const int hrs = multi_char_to_int(receivedChars[3], receivedChars[4]);
-	const int mins = multi_char_to_int(receivedChars[6], receivedChars[7]);
-	const int secs = multi_char_to_int(receivedChars[9], receivedChars[10]);
+	const int hrs = multi_char_to_int(arguments[1], arguments[2]);
+	const int mins = multi_char_to_int(arguments[4], arguments[5]);
+	const int secs = multi_char_to_int(arguments[7], arguments[8]);
+	if (hrs > 23 || mins > 59 || secs > 59) {
+		SerialReplies.print("0");
+		return false;
+	}
+
+	// Immediately confirm to Stellarium
+	SerialReplies.print("1");
 
 	DEBUG_PRINTLN();
 	DEBUG_PRINTLN("Changing RA");
@@ -269,21 +372,27 @@ void setRightAscension(Mount &telescope) {
 	#ifdef TARGET_SELECT_PIN
 		selectedDebugTargetIndex = -1;
 	#endif
+	return true;
 }
 
 // Set target Declination (in +/- degrees, minutes and seconds)
 // This doesn't yet set it on the telescope (happens in moveStart())
-void setDeclination(Mount &telescope) {
-	// Immediately confirm to Stellarium
-	Serial.print("1");
-
+// arguments is ",[+/-]DD:MM:SS" (see the command table below). Out of range values are rejected with "0". Returns false then
+bool setDeclination(Mount &telescope, const char* arguments) {
 	// Whether the coordinates are positive (1) or negative (-1)
-	const int multi = (receivedChars[3] == '+') ? 1 : -1;
+	const int multi = (arguments[1] == '+') ? 1 : -1;
 
 	// Parse the coordinates part of the command to integers
-	const int deg = multi_char_to_int(receivedChars[4], receivedChars[5]);
-	const int mins = multi_char_to_int(receivedChars[7], receivedChars[8]);
-	const int secs = multi_char_to_int(receivedChars[10], receivedChars[11]);
+	const int deg = multi_char_to_int(arguments[2], arguments[3]);
+	const int mins = multi_char_to_int(arguments[5], arguments[6]);
+	const int secs = multi_char_to_int(arguments[8], arguments[9]);
+	if (deg > 90 || mins > 59 || secs > 59 || (deg == 90 && (mins > 0 || secs > 0))) {
+		SerialReplies.print("0");
+		return false;
+	}
+
+	// Immediately confirm to Stellarium
+	SerialReplies.print("1");
 
 	DEBUG_PRINTLN();
 	DEBUG_PRINTLN("Changing DEC");
@@ -299,188 +408,409 @@ void setDeclination(Mount &telescope) {
 	#ifdef TARGET_SELECT_PIN
 		selectedDebugTargetIndex = -1;
 	#endif
+	return true;
 }
 
 
-/**
- * This gets called whenever a complete command was received.
- * It parses the received characters and calls the required functions
- * TODO Break this up into small functions so that the code stays maintainable
+/*
+ * Command table
+ * Each command has a name of up to 4 characters, the format of its arguments and a handler. The handlers get the
+ * characters after the name and return true if the command switched the telescope to Mode::TRACKING.
+ *
+ * parseCommands() switches on the first two characters of the command, packed into one number (see COMMAND_ID), to
+ * find the command, and then compares the rest of the name. So every command is found in the same time, no matter
+ * how many there are, and the frequent :GR# / :GD# polls of Stellarium do not go through a chain of comparisons.
+ * The first two characters of the names must be unique.
+ *
+ * The arguments are checked against the format before the handler runs. In a format,
+ *     d  is a digit
+ *     s  is a sign (+ or -)
+ *     ?  is any character (separators, which differ between programs)
+ *     |  separates alternatives. The arguments must match one of them, e.g. "|RST" for none or RST
+ * Any other character must match exactly. Arguments that do not match are rejected, so the handlers never read past the end of them
  */
-bool parseCommands(Mount &telescope, Observer& observer) {
-	if (newData == true) {
-		if (receivedChars[0] == 'G' && receivedChars[1] == 'R') {
-			// GR: Get Right Ascension
-			getRightAscension(telescope);
-		} else if (receivedChars[0] == 'G' && receivedChars[1] == 'D') {
-			// GD: Get Declination
-			getDeclination(telescope);
-		} else if (receivedChars[0] == 'Q') {
-			// Quit the current move
-			moveQuit(telescope);
-		} else if (receivedChars[0] == 'M' && receivedChars[1] == 'S') {
-			// MS: Move Start
-			// The function returning true means that isAligned was set to true.
-			if (moveStart(telescope)) {
-				// Ignores the next movement update and treats it as a home command instead
-				//telescope.ignoreUpdates();
-
-				newData = false;
-				// Aligning was just performed
-				return true;
+#define COMMAND_ID(first, second) ((static_cast<uint16_t>(first) << 8) | static_cast<uint8_t>(second))
+
+typedef bool (*CommandHandler)(Mount& telescope, Observer& observer, const char* arguments);
+
+struct SerialCommand {
+	const char* name;
+	const char* format;
+	CommandHandler handler;
+
+	// Reply to arguments that do not match the format. nullptr prints an error message
+	const char* rejection;
+};
+
+// Does the text match the alternative at the beginning of format (see above)?
+static bool matchesAlternative(const char* text, const char* format) {
+	for (; *format != '\0' && *format != '|'; format++, text++) {
+		const char c = *text;
+		switch (*format) {
+		case 'd':
+			if (c < '0' || c > '9') {
+				return false;
 			}
-			else {
-				// The telescope should not ignore movement updates once homed
-				telescope.ignoreUpdates(false);
+			break;
+		case 's':
+			if (c != '+' && c != '-') {
+				return false;
 			}
-		} else if (receivedChars[0] == 'S' && receivedChars[1] == 'r') {
-			// Set Right Ascension (in hours, minutes and seconds)
-			//telescope.ignoreUpdates();
-			setRightAscension(telescope);
-			display_statusUpdate(telescope);
-		} else if (receivedChars[0] == 'S' && receivedChars[1] == 'd') {
-			// Set target Declination (in degrees, minutes and seconds)
-			//telescope.ignoreUpdates();
-			setDeclination(telescope);
-			display_statusUpdate(telescope);
-		}
-		else if (receivedChars[0] == 'T' && receivedChars[1] == 'R' && receivedChars[2] == 'K') {
-			// Enable / Disable tracking (= home off / on)
-			if (receivedChars[3] == '1') {
-				telescope.setHomed(true);
-				Serial.println("Enabled tracking");
-
-				newData = false;
-				return true;
+			break;
+		case '?':
+			if (c == '\0') {
+				return false;
 			}
-			else if (receivedChars[3] == '0') {
-				telescope.setHomed(false);
-				Serial.println("Disabled tracking");
+			break;
+		default:
+			if (c != *format) {
+				return false;
 			}
+			break;
+		}
+	}
+	return *text == '\0';
+}
+
+// Does the text match one of the alternatives of the format?
+static bool matchesFormat(const char* text, const char* format) {
+	while (!matchesAlternative(text, format)) {
+		format = strchr(format, '|');
+		if (format == nullptr) {
+			return false;
 		}
-		else if (receivedChars[0] == 'S' && receivedChars[1] == 'T' && receivedChars[2] == 'P') {
-			// Enable / Disable stepper motors
-			if (receivedChars[3] == '1') {
-				digitalWrite(ALT_ENABLE_PIN, LOW);
-				digitalWrite(AZ_ENABLE_PIN, LOW);
-				Serial.println("Enabled stepper motors. Send :STP0# to disable them");
+		format++;
+	}
+	return true;
+}
+
+
+bool commandGetRightAscension(Mount& telescope, Observer& observer, const char* arguments) {
+	getRightAscension(telescope);
+	return false;
+}
+
+bool commandGetDeclination(Mount& telescope, Observer& observer, const char* arguments) {
+	getDeclination(telescope);
+	return false;
+}
+
+bool commandMoveQuit(Mount& telescope, Observer& observer, const char* arguments) {
+	moveQuit(telescope);
+	return false;
+}
+
+bool commandMoveStart(Mount& telescope, Observer& observer, const char* arguments) {
+	// The function returning true means that isAligned was set to true.
+	if (moveStart(telescope)) {
+		// Aligning was just performed
+		return true;
+	}
+	// The telescope should not ignore movement updates once homed
+	telescope.ignoreUpdates(false);
+	return false;
+}
+
+bool commandSetRightAscension(Mount& telescope, Observer& observer, const char* arguments) {
+	if (setRightAscension(telescope, arguments)) {
+		display_statusUpdate(telescope);
+	}
+	return false;
+}
+
+bool commandSetDeclination(Mount& telescope, Observer& observer, const char* arguments) {
+	if (setDeclination(telescope, arguments)) {
+		display_statusUpdate(telescope);
+	}
+	return false;
+}
+
+// Enable / Disable tracking (= home off / on)
+bool commandTracking(Mount& telescope, Observer& observer, const char* arguments) {
+	if (arguments[0] == '1') {
+		telescope.setHomed(true);
+		SerialReplies.println("Enabled tracking");
+		return true;
+	}
+	else if (arguments[0] == '0') {
+		telescope.setHomed(false);
+		SerialReplies.println("Disabled tracking");
+	}
+	return false;
+}
+
+// Enable / Disable stepper motors
+bool commandSteppers(Mount& telescope, Observer& observer, const char* arguments) {
+	if (arguments[0] == '1') {
+		FastPin<ALT_ENABLE_PIN>::write(LOW);
+		FastPin<AZ_ENABLE_PIN>::write(LOW);
+		SerialReplies.println("Enabled stepper motors. Send :STP0# to disable them");
+	}
+	else if (arguments[0] == '0') {
+		FastPin<ALT_ENABLE_PIN>::write(HIGH);
+		FastPin<AZ_ENABLE_PIN>::write(HIGH);
+		SerialReplies.println("Disabled stepper motors. Send :STP1# to re-enable them");
+	}
+	return false;
+}
+
+// DEBUG messages. arguments is everything after "DBG"
+bool commandDebug(Mount& telescope, Observer& observer, const char* arguments) {
+	if (arguments[0] == 'M') {
+		if (arguments[1] == 'I' || arguments[1] == 'D') {
+			// Increase or Decrease Azimuth or Declination
+			int add = arguments[1] == 'I' ? 1 : -1;
+			if (arguments[2] == 'A') {
+				// DBGMAXXX Move Azimuth to XXX
+				ra_deg += add;
+				RaDecPosition pos = telescope.getTarget();
+				pos.rightAscension += add;
+				telescope.setTarget(pos);
+				SerialReplies.println(
+						add > 0 ?
+								"Add 1 deg ascension" :
+								"Sub 1 deg ascension");
+				display_statusUpdate(telescope);
+			} else if (arguments[2] == 'D') {
+				// DBGMD[+/-]XX Move Declination to +/-XX
+				dec_deg += add;
+				RaDecPosition pos = telescope.getTarget();
+				pos.declination += add;
+				telescope.setTarget(pos);
+				SerialReplies.println(
+						add > 0 ?
+								"Add 1 deg declination" :
+								"Sub 1 deg declination");
+				display_statusUpdate(telescope);
 			}
-			else if (receivedChars[3] == '0') {
-				digitalWrite(ALT_ENABLE_PIN, HIGH);
-				digitalWrite(AZ_ENABLE_PIN, HIGH);
-				Serial.println("Disabled stepper motors. Send :STP1# to re-enable them");
+		} else {
+			// Debug move to position stored in debugPositions[targetIndex]
+			int targetIndex = char_to_int(arguments[1]);
+			if (targetIndex < 0 || targetIndex >= maxDebugPos) {
+				SerialReplies.println("Invalid index");
+			} else {
+				SerialReplies.println();
+				SerialReplies.println("-----------------------------------------");
+				SerialReplies.println("Moving telescope to new target");
+
+				SerialReplies.print("Name\t");
+				SerialReplies.println(positionNames[targetIndex]);
+				SerialReplies.print("Ra\t");
+				SerialReplies.print(debugPositions[targetIndex][0]);
+				SerialReplies.println("");
+				SerialReplies.print("Dec\t");
+				SerialReplies.print(debugPositions[targetIndex][1]);
+				SerialReplies.println("");
+
+
+				SerialReplies.println("-----------------------------------------");
+
+				ra_deg = debugPositions[targetIndex][0];
+				dec_deg = debugPositions[targetIndex][1];
+				RaDecPosition newPos = { debugPositions[targetIndex][0], debugPositions[targetIndex][1] };
+				SerialReplies.print("Scope msg: ");
+				telescope.setTarget(newPos);
+				SerialReplies.println();
+				SerialReplies.println();
+				display_statusUpdate(telescope);
+
+				// If there is a target select button we need to store the selected position in
+				#ifdef TARGET_SELECT_PIN
+					selectedDebugTargetIndex = targetIndex;
+				#endif
 			}
 		}
-		else if (receivedChars[0] == 'D' && receivedChars[1] == 'B'
-				&& receivedChars[2] == 'G') {
-			// DEBUG messages
-			if (receivedChars[3] == 'M') {
-				if (receivedChars[4] == 'I' || receivedChars[4] == 'D') {
-					// Increase or Decrease Azimuth or Declination
-					int add = receivedChars[4] == 'I' ? 1 : -1;
-					if (receivedChars[5] == 'A') {
-						// DBGMAXXX Move Azimuth to XXX
-						ra_deg += add;
-						RaDecPosition pos = telescope.getTarget();
-						pos.rightAscension += add;
-						telescope.setTarget(pos);
-						Serial.println(
-								add > 0 ?
-										"Add 1 deg ascension" :
-										"Sub 1 deg ascension");
-						display_statusUpdate(telescope);
-					} else if (receivedChars[5] == 'D') {
-						// DBGMD[+/-]XX Move Declination to +/-XX
-						dec_deg += add;
-						RaDecPosition pos = telescope.getTarget();
-						pos.declination += add;
-						telescope.setTarget(pos);
-						Serial.println(
-								add > 0 ?
-										"Add 1 deg declination" :
-										"Sub 1 deg declination");
-						display_statusUpdate(telescope);
-					}
-				} else {
-					// Debug move to position stored in debugPositions[targetIndex]
-					int targetIndex = char_to_int(receivedChars[4]);
-					if (targetIndex > maxDebugPos) {
-						Serial.println("Invalid index");
-					} else {
-						Serial.println();
-						Serial.println("-----------------------------------------");
-						Serial.println("Moving telescope to new target");
-
-						Serial.print("Name\t");
-						Serial.println(positionNames[targetIndex]);
-						Serial.print("Ra\t");
-						Serial.print(debugPositions[targetIndex][0]);
-						Serial.println("");
-						Serial.print("Dec\t");
-						Serial.print(debugPositions[targetIndex][1]);
-						Serial.println("");
-
-
-						Serial.println("-----------------------------------------");
-
-						ra_deg = debugPositions[targetIndex][0];
-						dec_deg = debugPositions[targetIndex][1];
-						RaDecPosition newPos = { debugPositions[targetIndex][0], debugPositions[targetIndex][1] };
-						Serial.print("Scope msg: ");
-						telescope.setTarget(newPos);
-						Serial.println();
-						Serial.println();
-						display_statusUpdate(telescope);
-
-						// If there is a target select button we need to store the selected position in 
-						#ifdef TARGET_SELECT_PIN
-							selectedDebugTargetIndex = targetIndex;
-						#endif
-					}
-				}
-			} else if (receivedChars[3] == 'H') {
-				// Home the scope
-				telescope.setHomed(true);
-			} else if (receivedChars[3] == 'D' && receivedChars[4] == 'M') {
-				// Disable Motors and Pause for X seconds
-				digitalWrite(ALT_ENABLE_PIN, HIGH);
-				digitalWrite(AZ_ENABLE_PIN, HIGH);
-				Serial.print("Disabling motors for: ");
-				const int disable_seconds = multi_char_to_int(receivedChars[5], receivedChars[6]);
-				Serial.println(disable_seconds);
-				delay(disable_seconds * 1000);
-				Serial.println("Continuing");
-				digitalWrite(ALT_ENABLE_PIN, LOW);
-				digitalWrite(AZ_ENABLE_PIN, LOW);
-			} else if (receivedChars[3] == 'G' && receivedChars[4] == 'P' && receivedChars[5] == 'S') {
-				// Observer/Gps Debug info
-				observer.printDebugInfo();
+	} else if (arguments[0] == 'H') {
+		// Home the scope
+		telescope.setHomed(true);
+	} else if (arguments[0] == 'D' && arguments[1] == 'M') {
+		// Disable Motors for X seconds. Commands are still handled meanwhile, resumeMotors() ends the pause
+		FastPin<ALT_ENABLE_PIN>::write(HIGH);
+		FastPin<AZ_ENABLE_PIN>::write(HIGH);
+		SerialReplies.print("Disabling motors for: ");
+		const int disable_seconds = multi_char_to_int(arguments[2], arguments[3]);
+		SerialReplies.println(disable_seconds);
+		TimedActions::start(&resumeMotors, disable_seconds * 1000UL);
+	} else if (arguments[0] == 'G' && arguments[1] == 'P' && arguments[2] == 'S') {
+		// Observer/Gps Debug info
+		observer.printDebugInfo();
+	} else if (arguments[0] == 'I' && arguments[1] == 'S' && arguments[2] == 'R') {
+		// Longest stepper interrupt since startup or the last :DBGISR#
+		SerialReplies.print("Longest stepper interrupt: ");
+		SerialReplies.print(StepGenerator::worstTickMicros());
+		SerialReplies.print("us of ");
+		SerialReplies.print(STEPPER_INTERRUPT_FREQ);
+		SerialReplies.println("us");
+		StepGenerator::resetWorstTick();
+	}
+	#ifdef SERIAL_DISPLAY_ENABLED
+		else if (arguments[0] == 'D' && arguments[1] == 'S' && arguments[2] == 'P') {
+			// Send the "Status: Online" command to the display
+			SerialReplies.println("Sending status update (online) to display");
+			display_statusUpdate(telescope);
+			SerialReplies.println("Done...");
+		}
+	#endif
+	return false;
+}
+
+// Timing counters (see Profiler.h) and output counters (see SerialOutput.h). :PERF# prints them, :PERFRST# resets them
+bool commandPerformance(Mount& telescope, Observer& observer, const char* arguments) {
+	if (strcmp(arguments, "RST") == 0) {
+		Profiler::reset();
+		SerialOutput::resetStatistics();
+		SerialReplies.println("Timing counters reset");
+	}
+	else {
+		Profiler::print(SerialReplies);
+		SerialOutput::printStatistics(SerialReplies);
+	}
+	return false;
+}
+
+// LX200 :U# has no reply
+bool commandPrecision(Mount& telescope, Observer& observer, const char* arguments) {
+	togglePrecision();
+	return false;
+}
+
+// :TLM<rate># starts the binary telemetry stream with rate frames per second, :TLM0# stops it (see Telemetry.h)
+bool commandTelemetry(Mount& telescope, Observer& observer, const char* arguments) {
+	const int rate = arguments[1] == '\0' ? char_to_int(arguments[0]) : multi_char_to_int(arguments[0], arguments[1]);
+	if (rate > Telemetry::MAX_RATE) {
+		SerialReplies.print("ERROR: Telemetry rate must be 0 - ");
+		SerialReplies.println(Telemetry::MAX_RATE);
+		return false;
+	}
+
+	if (rate == 0) {
+		Telemetry::start(0);
+		SerialReplies.print("Telemetry stopped, frames dropped: ");
+		SerialReplies.println(Telemetry::droppedFrames());
+	}
+	else {
+		SerialReplies.print("Telemetry at ");
+		SerialReplies.print(rate);
+		SerialReplies.println(" Hz");
+		Telemetry::start(rate);
+	}
+	return false;
+}
+
+bool commandHelp(Mount& telescope, Observer& observer, const char* arguments) {
+	printHelp();
+	return false;
+}
+
+
+// The subcommands of :DBG (see printHelp())
+#ifdef SERIAL_DISPLAY_ENABLED
+	#define DEBUG_COMMAND_FORMAT "Md|MIA|MDA|MID|MDD|H|DMdd|GPS|ISR|DSP"
+#else
+	#define DEBUG_COMMAND_FORMAT "Md|MIA|MDA|MID|MDD|H|DMdd|GPS|ISR"
+#endif
+
+// Stellarium expects "0" for coordinates it can not set
+const SerialCommand commandGR = { "GR", "", &commandGetRightAscension, nullptr };
+const SerialCommand commandGD = { "GD", "", &commandGetDeclination, nullptr };
+const SerialCommand commandQ = { "Q", "", &commandMoveQuit, nullptr };
+const SerialCommand commandMS = { "MS", "", &commandMoveStart, nullptr };
+const SerialCommand commandSr = { "Sr", "?dd?dd?dd", &commandSetRightAscension, "0" };
+const SerialCommand commandSd = { "Sd", "?sdd?dd?dd", &commandSetDeclination, "0" };
+const SerialCommand commandTRK = { "TRK", "d", &commandTracking, nullptr };
+const SerialCommand commandSTP = { "STP", "d", &commandSteppers, nullptr };
+const SerialCommand commandDBG = { "DBG", DEBUG_COMMAND_FORMAT, &commandDebug, nullptr };
+const SerialCommand commandPERF = { "PERF", "|RST", &commandPerformance, nullptr };
+const SerialCommand commandHLP = { "HLP", "", &commandHelp, nullptr };
+const SerialCommand commandU = { "U", "", &commandPrecision, nullptr };
+const SerialCommand commandTLM = { "TLM", "d|dd", &commandTelemetry, nullptr };
+
+// The command whose name starts with the first two characters of command, or nullptr
+static const SerialCommand* findCommand(const char* command) {
+	switch (COMMAND_ID(command[0], command[0] == '\0' ? '\0' : command[1])) {
+	case COMMAND_ID('G', 'R'): return &commandGR;
+	case COMMAND_ID('G', 'D'): return &commandGD;
+	case COMMAND_ID('Q', '\0'): return &commandQ;
+	case COMMAND_ID('M', 'S'): return &commandMS;
+	case COMMAND_ID('S', 'r'): return &commandSr;
+	case COMMAND_ID('S', 'd'): return &commandSd;
+	case COMMAND_ID('T', 'R'): return &commandTRK;
+	case COMMAND_ID('S', 'T'): return &commandSTP;
+	case COMMAND_ID('D', 'B'): return &commandDBG;
+	case COMMAND_ID('P', 'E'): return &commandPERF;
+	case COMMAND_ID('H', 'L'): return &commandHLP;
+	case COMMAND_ID('U', '\0'): return &commandU;
+	case COMMAND_ID('T', 'L'): return &commandTLM;
+	default: return nullptr;
+	}
+}
+
+
+/**
+ * Looks the command up in the command table, checks its arguments and runs its handler
+ * Returns true if the command switched the telescope to Mode::TRACKING
+ */
+static bool runCommand(Mount &telescope, Observer& observer, const char* received) {
+	const SerialCommand* command = findCommand(received);
+	if (command == nullptr) {
+		SerialReplies.println("ERROR: Unknown command");
+		SerialReplies.println(received);
+		return false;
+	}
+
+	// The first two characters matched already
+	uint8_t length = 2;
+	if (command->name[1] == '\0') {
+		length = 1;
+	}
+	else {
+		for (; command->name[length] != '\0'; length++) {
+			if (received[length] != command->name[length]) {
+				SerialReplies.println("ERROR: Unknown command");
+				SerialReplies.println(received);
+				return false;
 			}
-			#ifdef SERIAL_DISPLAY_ENABLED
-				else if (receivedChars[3] == 'D' && receivedChars[4] == 'S' && receivedChars[5] == 'P') {
-					// Send the "Status: Online" command to the display
-					Serial.println("Sending status update (online) to display");
-					display_statusUpdate(telescope);
-					Serial.println("Done...");
-				}
-			#endif
-		} else if (receivedChars[0] == 'H' && receivedChars[1] == 'L' && receivedChars[2] == 'P') {
-			printHelp();
-		} else {
-			Serial.println("ERROR: Unknown command");
-			Serial.println(receivedChars);
 		}
-		newData = false;
+	}
+
+	const char* arguments = received + length;
+	if (command->format != nullptr && !matchesFormat(arguments, command->format)) {
+		if (command->rejection != nullptr) {
+			SerialReplies.print(command->rejection);
+		}
+		else {
+			SerialReplies.println("ERROR: Invalid arguments");
+			SerialReplies.println(received);
+		}
+		return false;
+	}
+
+	return command->handler(telescope, observer, arguments);
+}
+
+
+/**
+ * Runs the queued commands in the order they were received.
+ * A command that switches to Mode::TRACKING ends the run and the function returns true, so that the caller can
+ * finish the switch before the commands that were sent after it are run (in the next call)
+ */
+bool parseCommands(Mount &telescope, Observer& observer) {
+	while (!receivedCommands.isEmpty()) {
+		const bool switchedToTracking = runCommand(telescope, observer, receivedCommands.peek().text);
+		receivedCommands.pop();
+		if (switchedToTracking) {
+			return true;
+		}
 	}
 	return false;
 }
 
 bool handleSerialCommunication(Mount &telescope, Observer &observer) {
-	// Receives the next command character, if available
-	receiveCommandChar();
+	// Receives all available command characters and queues the complete commands
+	receiveCommands();
 
-	// Once a complete command has been received, this parses and runs the command
-	// Returns true, if the received command triggered a change from Mode::ALIGNING to Mode::TRACKING
+	// This parses and runs the queued commands
+	// Returns true, if a received command triggered a change from Mode::ALIGNING to Mode::TRACKING
 	bool switchedToTracking = parseCommands(telescope, observer);
 
 	// If we have a target select button it gets handled here
@@ -504,9 +834,8 @@ bool handleSerialCommunication(Mount &telescope, Observer &observer) {
 				// Print confirmation and buzz
 				DEBUG_PRINTLN("Switching target to " + String(selectedDebugTargetIndex));
 				#ifdef BUZZER_PIN
-					digitalWrite(BUZZER_PIN, HIGH);
-					delay(100);
-					digitalWrite(BUZZER_PIN, LOW);
+					FastPin<BUZZER_PIN>::write(HIGH);
+					TimedActions::start(&buzzerOff, 100);
 				#endif
 			}
 		}
@@ -17,5 +17,8 @@
 
 void initCommunication(Mount& telescope);
 bool parseCommands(Mount &telescope, Observer& observere);
-void receiveCommandChar();
-bool handleSerialCommunication(Mount &telescope, Observer& observer);
\ No newline at end of file
+void receiveCommands();
+bool handleSerialCommunication(Mount &telescope, Observer& observer);
+
+// True while :DBGDM## keeps the stepper drivers disabled
+bool steppersPaused();
\ No newline at end of file
@@ -6,6 +6,13 @@
 
 #include "config.h"
 #include "conversion.h"
+#include "Profiler.h"
+#include "Scheduler.h"
+#include "SerialOutput.h"
+#include "Tasks.h"
+#include "TimedActions.h"
+#include "StepGenerator.h"
+#include "Telemetry.h"
 //#include "location.h"
 
 //Load the timer library, depending on the selected BOARD_TYPE
@@ -37,9 +44,9 @@
 #endif
 
 
-// Initialize the Steppers
-AccelStepper azimuth(AccelStepper::DRIVER, AZ_STEP_PIN, AZ_DIR_PIN);    // Azimuth stepper
-AccelStepper altitude(AccelStepper::DRIVER, ALT_STEP_PIN, ALT_DIR_PIN); // Altitude stepper
+// Initialize the Steppers. MountStepper is StepGenerator or AccelStepper, depending on STEP_GENERATOR
+MountStepper azimuth(MOUNT_STEPPER_PINS(AZ_STEP_PIN, AZ_DIR_PIN));    // Azimuth stepper
+MountStepper altitude(MOUNT_STEPPER_PINS(ALT_STEP_PIN, ALT_DIR_PIN)); // Altitude stepper
 
 // Initialize the Observer (either fixed or GPS)
 #ifdef GPS_FIXED_POS
@@ -57,18 +64,6 @@ AccelStepper altitude(AccelStepper::DRIVER, ALT_STEP_PIN, ALT_DIR_PIN); // Altit
 	DirectDrive scope(azimuth, altitude, observer);
 #endif
 
-// Are the stepper drivers currently enabled?
-bool motorsEnabled = false;
-
-// This increases every loop iteration and resets at 10.000
-unsigned int loopIteration = 0;
-
-// Is the loop() function being run for the first time?
-bool first_loop_run = true;
-
-// millis() at the time of the latest call to Mount::calculateMotorTargets()
-long last_motor_update = 0;
-
 #ifdef DEBUG_HOME_IMMEDIATELY
 	const bool homeImmediately = true;
 #else
@@ -76,14 +71,111 @@ long last_motor_update = 0;
 #endif
 
 
-/**
- * Motor Interrupt handler
- * This is attached to timer interrupt 1. It gets called every STEPPER_INTERRUPT_FREQ / 1.000.000 seconds and moves our steppers
- */
-void moveSteppers() {
-	azimuth.run();
-	altitude.run();
-}
+#ifdef STEP_GENERATOR
+	// Timer counts per microsecond. See setupSteppers()
+	#ifdef BOARD_ARDUINO_MEGA
+		const unsigned long STEP_TIMER_COUNTS_PER_MICROSECOND = 2;
+	#elif defined BOARD_ARDUINO_DUE
+		const unsigned long STEP_TIMER_COUNTS_PER_MICROSECOND = 42;
+	#endif
+
+	// Microseconds from the previous to the current stepper interrupt. Written by scheduleStepperInterrupt()
+	unsigned long stepperInterruptInterval = STEPPER_INTERRUPT_FREQ;
+
+	/**
+	 * Sets the time of the next stepper interrupt to wait microseconds after the current one, but at least STEP_TIMER_MIN_MICROS
+	 * and at most STEP_TIMER_MAX_MICROS. The timers count from the current interrupt on, so the time the interrupt takes does not add up.
+	 * If the counter is already past the new compare value, the interrupt is moved to STEP_TIMER_MIN_MICROS from now instead,
+	 * because the counter would otherwise run until it overflows
+	 */
+	void scheduleStepperInterrupt(unsigned long wait) {
+		wait = constrain(wait, STEP_TIMER_MIN_MICROS, STEP_TIMER_MAX_MICROS);
+		const unsigned long earliest = STEP_TIMER_MIN_MICROS * STEP_TIMER_COUNTS_PER_MICROSECOND;
+
+	#ifdef BOARD_ARDUINO_MEGA
+		unsigned long top = wait * STEP_TIMER_COUNTS_PER_MICROSECOND - 1;
+		const unsigned long now = TCNT1;
+		if (top < now + earliest) {
+			top = now + earliest;
+		}
+		ICR1 = top;
+		stepperInterruptInterval = (top + 1) / STEP_TIMER_COUNTS_PER_MICROSECOND;
+	#elif defined BOARD_ARDUINO_DUE
+		unsigned long compare = wait * STEP_TIMER_COUNTS_PER_MICROSECOND;
+		const unsigned long now = TC2->TC_CHANNEL[1].TC_CV;
+		if (compare < now + earliest) {
+			compare = now + earliest;
+		}
+		TC_SetRC(TC2, 1, compare);
+		stepperInterruptInterval = compare / STEP_TIMER_COUNTS_PER_MICROSECOND;
+	#endif
+	}
+
+
+	/**
+	 * Motor Interrupt handler
+	 * This is attached to timer interrupt 1. Each call makes the steps that are due and schedules the next call for the next step
+	 * of either stepper (see StepGenerator.h). It first starts the motion segments the main loop queued (see Mount::startDueSegments()). While the mount tracks at a set speed or along a trajectory, run() must not be used,
+	 * because it would replace the speed with its own ramp to the target position
+	 * At the end, it publishes the positions of the steppers for the main loop (see Mount::stepperSnapshot())
+	 * The duration of every call and how late it started are measured, see StepGenerator::worstTickMicros() and Profiler.h
+	 */
+	void moveSteppers() {
+		const unsigned long tickStart = StepGenerator::startTick();
+		const unsigned long elapsed = stepperInterruptInterval;
+		scope.startDueSegments(elapsed);
+
+		unsigned long azimuthWait;
+		unsigned long altitudeWait;
+		switch (scope.getDriveMode()) {
+		case DRIVE_AT_SPEED:
+			azimuthWait = azimuth.runSpeed(elapsed);
+			altitudeWait = altitude.runSpeed(elapsed);
+			break;
+		case DRIVE_ALONG_TRAJECTORY:
+			azimuthWait = altitudeWait = scope.stepAlongTrajectory(elapsed);
+			break;
+		default:
+			azimuthWait = azimuth.run(elapsed);
+			altitudeWait = altitude.run(elapsed);
+			break;
+		}
+		scheduleStepperInterrupt(min(azimuthWait, altitudeWait));
+
+		scope.publishSteppers(azimuth.currentPosition(), altitude.currentPosition(), tickStart);
+		Profiler::recordTick(tickStart, elapsed, StepGenerator::endTick(tickStart));
+	}
+#else
+	/**
+	 * Motor Interrupt handler
+	 * This is attached to timer interrupt 1. It gets called every STEPPER_INTERRUPT_FREQ / 1.000.000 seconds and moves our steppers.
+	 * It first starts the motion segments the main loop queued (see Mount::startDueSegments())
+	 * While the mount tracks at a set speed or along a trajectory, run() must not be used, because it would replace the speed with its own ramp to the target position
+	 * At the end, it publishes the positions of the steppers for the main loop (see Mount::stepperSnapshot())
+	 * The duration of every call and how late it started are measured, see StepGenerator::worstTickMicros() and Profiler.h
+	 */
+	void moveSteppers() {
+		const unsigned long tickStart = StepGenerator::startTick();
+		scope.startDueSegments(STEPPER_INTERRUPT_FREQ);
+
+		switch (scope.getDriveMode()) {
+		case DRIVE_AT_SPEED:
+			azimuth.runSpeed();
+			altitude.runSpeed();
+			break;
+		case DRIVE_ALONG_TRAJECTORY:
+			scope.stepAlongTrajectory();
+			break;
+		default:
+			azimuth.run();
+			altitude.run();
+			break;
+		}
+
+		scope.publishSteppers(azimuth.currentPosition(), altitude.currentPosition(), tickStart);
+		Profiler::recordTick(tickStart, STEPPER_INTERRUPT_FREQ, StepGenerator::endTick(tickStart));
+	}
+#endif
 
 
 /**
@@ -91,8 +183,8 @@ void moveSteppers() {
  */
 void setupSteppers() {
 	// Set stepper pins
-	pinMode(AZ_ENABLE_PIN, OUTPUT);  // Azimuth pin
-	pinMode(ALT_ENABLE_PIN, OUTPUT); // Altitude pin
+	FastPin<AZ_ENABLE_PIN>::setOutput();  // Azimuth pin
+	FastPin<ALT_ENABLE_PIN>::setOutput(); // Altitude pin
 
 	azimuth.setPinsInverted(true, false, false);
 	azimuth.setMaxSpeed(AZ_MAX_SPEED);
@@ -106,10 +198,36 @@ void setupSteppers() {
 #ifdef BOARD_ARDUINO_MEGA
 	Timer1.initialize(STEPPER_INTERRUPT_FREQ);
 	Timer1.attachInterrupt(&moveSteppers);
+
+	#ifdef STEP_GENERATOR
+		// Fast PWM mode with ICR1 as TOP (mode 14) and a prescaler of 8: Timer1 counts twice per microsecond and
+		// restarts at ICR1, where TimerOne calls moveSteppers(). scheduleStepperInterrupt() sets ICR1
+		noInterrupts();
+		TCCR1A = _BV(WGM11);
+		TCCR1B = _BV(WGM13) | _BV(WGM12) | _BV(CS11);
+		ICR1 = STEPPER_INTERRUPT_FREQ * STEP_TIMER_COUNTS_PER_MICROSECOND - 1;
+		TCNT1 = 0;
+		interrupts();
+	#endif
 #elif defined BOARD_ARDUINO_DUE
-	Timer.getAvailable()
-		.attachInterrupt(&moveSteppers)
-		.start(STEPPER_INTERRUPT_FREQ);
+	#ifdef STEP_GENERATOR
+		// DueTimer's Timer7 is channel 1 of TC2. It counts at MCK / 2 (42 MHz) and restarts at RC, where DueTimer calls moveSteppers().
+		// scheduleStepperInterrupt() sets RC
+		Timer7.attachInterrupt(&moveSteppers);
+		pmc_set_writeprotect(false);
+		pmc_enable_periph_clk(ID_TC7);
+		TC_Configure(TC2, 1, TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC | TC_CMR_TCCLKS_TIMER_CLOCK1);
+		TC_SetRC(TC2, 1, STEPPER_INTERRUPT_FREQ * STEP_TIMER_COUNTS_PER_MICROSECOND);
+		TC2->TC_CHANNEL[1].TC_IER = TC_IER_CPCS;
+		TC2->TC_CHANNEL[1].TC_IDR = ~TC_IER_CPCS;
+		NVIC_ClearPendingIRQ(TC7_IRQn);
+		NVIC_EnableIRQ(TC7_IRQn);
+		TC_Start(TC2, 1);
+	#else
+		Timer.getAvailable()
+			.attachInterrupt(&moveSteppers)
+			.start(STEPPER_INTERRUPT_FREQ);
+	#endif
 #endif
 
 	DEBUG_PRINT("  Steppers enabled:  ");
@@ -127,45 +245,6 @@ void setupSteppers() {
 } // setupSteppers
 
 
-/*
- * This function turns stepper motor drivers on, if these conditions are met:
- * STEPPERS_ON_PIN reads HIGH
- * operating mode is not Mode::INITIALIZING
- * TODO Maybe the conditions need to change (esp. the opmode one)
- */
-void setSteppersOnOffState() {
-	const bool isTracking = scope.getMode() == Mode::TRACKING;
-
-#ifdef STEPPERS_ON_PIN
-	// If the STEPPERS_ON switch is installed, check its state
-	const bool steppersSwitchOn = digitalRead(STEPPERS_ON_PIN) == HIGH;
-#else
-	// If no STEPPERS_ON switch is installed, define its state as enabled
-#define steppersSwitchOn true
-#endif
-
-	if (steppersSwitchOn && isTracking) {
-		// Motors on
-		motorsEnabled = true;
-#ifdef AZ_ENABLE
-		digitalWrite(AZ_ENABLE_PIN, LOW);
-#endif
-#ifdef ALT_ENABLE
-		digitalWrite(ALT_ENABLE_PIN, LOW);
-#endif
-	}
-	else {
-		// Motors OFF
-		motorsEnabled = false;
-#ifdef AZ_ENABLE
-		digitalWrite(AZ_ENABLE_PIN, HIGH);
-#endif
-#ifdef ALT_ENABLE
-		digitalWrite(ALT_ENABLE_PIN, HIGH);
-#endif
-	}
-}
-
 #ifndef REMOVE_SPLASH
 	void greet() {
 		DEBUG_PRINTLN("                      __          __  _                          ");
@@ -261,6 +340,48 @@ void config_sanity_check() {
 		DEBUG_PRINTLN("  Warning: UPDATE_MOTOR_POS_MS should probably be > 0");
 		failed = true;
 	#endif
+
+	#if UPDATE_MOTOR_POS_MIN_MS <= 0 || UPDATE_MOTOR_POS_MIN_MS > UPDATE_MOTOR_POS_MS || UPDATE_MOTOR_POS_MAX_MS < UPDATE_MOTOR_POS_MS
+		DEBUG_PRINTLN("  Warning: UPDATE_MOTOR_POS_MIN_MS should be > 0 and <= UPDATE_MOTOR_POS_MS, UPDATE_MOTOR_POS_MAX_MS >= UPDATE_MOTOR_POS_MS");
+		failed = true;
+	#endif
+
+	#if defined TRACKING_VELOCITY_FEED_FORWARD && defined TRACKING_TRAJECTORY
+		DEBUG_PRINTLN("  Error: TRACKING_VELOCITY_FEED_FORWARD and TRACKING_TRAJECTORY can not be enabled at the same time.");
+		failed = true; can_continue = false;
+	#endif
+
+	#if defined TRACKING_TRAJECTORY && TRAJECTORY_REFIT_MS >= TRAJECTORY_WINDOW_MS
+		DEBUG_PRINTLN("  Warning: TRAJECTORY_REFIT_MS should be < TRAJECTORY_WINDOW_MS, or the trajectory runs out before it is refitted");
+		failed = true;
+	#endif
+
+	#if defined TRACKING_TRAJECTORY && MOTION_QUEUE_AHEAD_MS / TRAJECTORY_REFIT_MS + 2 > MOTION_QUEUE_LENGTH
+		DEBUG_PRINTLN("  Error: MOTION_QUEUE_LENGTH is too short for the trajectories queued within MOTION_QUEUE_AHEAD_MS");
+		failed = true; can_continue = false;
+	#endif
+
+	#if defined AZ_CABLE_WRAP_DEG && AZ_CABLE_WRAP_DEG < 180
+		DEBUG_PRINTLN("  Error: AZ_CABLE_WRAP_DEG must be >= 180, or some azimuths can not be reached");
+		failed = true; can_continue = false;
+	#endif
+
+	#if defined SLEW_PLANNER && SLEW_JERK_MS <= 0
+		DEBUG_PRINTLN("  Error: SLEW_JERK_MS must be > 0");
+		failed = true; can_continue = false;
+	#endif
+
+	#if MOTION_QUEUE_AHEAD_MS <= UPDATE_MOTOR_POS_MS
+		DEBUG_PRINTLN("  Warning: MOTION_QUEUE_AHEAD_MS should be > UPDATE_MOTOR_POS_MS, or the queued motion runs out between two updates");
+		failed = true;
+	#endif
+
+	#ifdef TRACKING_VELOCITY_FEED_FORWARD
+		if (TRACKING_CORRECTION_GAIN * UPDATE_MOTOR_POS_MS >= 1000.) {
+			DEBUG_PRINTLN("  Warning: TRACKING_CORRECTION_GAIN should be < 1000 / UPDATE_MOTOR_POS_MS, or tracking will oscillate");
+			failed = true;
+		}
+	#endif
 		
 
 	#if STEPPER_INTERRUPT_FREQ <= 0
@@ -268,6 +389,17 @@ void config_sanity_check() {
 		failed = true;
 	#endif
 
+	#ifdef STEP_GENERATOR
+		#if STEP_TIMER_MIN_MICROS >= STEP_TIMER_MAX_MICROS
+			DEBUG_PRINTLN("  Error: STEP_TIMER_MIN_MICROS must be < STEP_TIMER_MAX_MICROS");
+			failed = true; can_continue = false;
+		#endif
+		#if defined BOARD_ARDUINO_MEGA && STEP_TIMER_MAX_MICROS > 32767
+			DEBUG_PRINTLN("  Error: STEP_TIMER_MAX_MICROS must be <= 32767 on the Arduino Mega");
+			failed = true; can_continue = false;
+		#endif
+	#endif
+
 	// End checks
 
 	if (failed) {
@@ -279,7 +411,7 @@ void config_sanity_check() {
 			while (stop) {
 				// Buzzer is installed. Start buzzing and continue endless loop
 				#ifdef BUZZER_PIN
-					digitalWrite(BUZZER_PIN, HIGH);
+					FastPin<BUZZER_PIN>::write(HIGH);
 				#endif
 
 				// DEBUG_SERIAL is enabled. Wait for "ok" input
@@ -298,12 +430,13 @@ void config_sanity_check() {
 			}
 			// Buzzer is installed. Stop buzzing after the continue command
 			#ifdef BUZZER_PIN
-				digitalWrite(BUZZER_PIN, LOW);
+				FastPin<BUZZER_PIN>::write(LOW);
 			#endif
 		#endif
 	}
 }
 
+
 /**
  * Run various tasks required to initialize the following:
  * Serial connection
@@ -366,10 +499,10 @@ void setup() {
 	DEBUG_PRINT("    Buzzer...............");
 	// Button pins
 	#ifdef BUZZER_PIN
-		pinMode(BUZZER_PIN, OUTPUT);
-		digitalWrite(BUZZER_PIN, HIGH);
+		FastPin<BUZZER_PIN>::setOutput();
+		FastPin<BUZZER_PIN>::write(HIGH);
 		//delay(1000);
-		digitalWrite(BUZZER_PIN, LOW);
+		FastPin<BUZZER_PIN>::write(LOW);
 		DEBUG_PRINLN("done");
 	#else
 		DEBUG_PRINTLN("not connected");
@@ -412,102 +545,32 @@ void setup() {
 		display_statusUpdate(scope);
 	#endif
 
+	// If DEBUG_HOME_IMMEDIATELY is defined, homing is performed right away.
+	// Otherwise a serial command or HOME_NOW Button are required
+	if (homeImmediately) {
+		// Sets the telescope to operating mode Mode::TRACKING
+		scope.setHomed(true);
+	}
+
 	DEBUG_PRINTLN("> Initialization done");
 	DEBUG_PRINTLN();
 	DEBUG_PRINTLN();
 	DEBUG_PRINTLN();
 
+	// From now on output is buffered and sent by the serial task (see SerialOutput.h)
+	SerialOutput::setBuffered(true);
+
+	Profiler::setScheduler(scheduler);
+	scheduler.start();
 }
 
 
 /*
- * Main program loop. It does roughly the following (in order)
- * 1) Check whether the Home Button is pressed. If so, set the scope back to homing mode
- * 2) Get updates from the GPS module and tell the telescope instance about it
- * 3) Handle communication over serial
- * 4) Check whether homing mode should end (TODO This should move to the telescope class)
- * 5) Turn the stepper drivers on/off
- * 6) Every 10.000 loop iterations:
- *    - Run the necessary calculations to update the telescope target position
- *    - Update the target values for the steppers
- * 7) Debug communications, if enabled
+ * Main program loop. Each call runs the most urgent of the tasks above (see Scheduler::runNext())
+ * The duration of every iteration goes into the loop histogram of :PERF# (see Profiler.h)
 */
 void loop() {
-	#ifdef HOME_NOW_PIN
-		// If the HOME button is installed and pressed/switched on start homing mode
-		const bool currentlyAligning = digitalRead(HOME_NOW_PIN) == HIGH;
-
-		if (currentlyAligning) {
-			// The telescope stands still and waits for the next target selection (which it then assumes it is pointing at)
-			// Setting homed to false also sets the telescope to operating mode Mode::ALIGNING
-			scope.setHomed(false);
-		}
-	#else
-		// If no HOME button exists, it never gets pressed, so we define it as false
-		#define currentlyAligning false
-	#endif
-
-	// Get the current position from our GPS module. If no GPS is installed
-	// or no fix is available values from EEPROM / config.h are used.
-	// For more details look at the implementations of the Observer class
-	observer.updatePosition();
-
-	// Handle serial serial communication. Returns true if homing was just performed
-	bool justAligned = handleSerialCommunication(scope, observer);
-
-	#ifdef SERIAL_DISPLAY_ENABLED
-		handleDisplayCommunication(scope, observer);
-	#endif
-
-	// If DEBUG_HOME_IMMEDIATELY is defined, homing is performed on first loop iteration.
-	// Otherwise a serial command or HOME_NOW Button are required
-	if (justAligned || currentlyAligning
-		|| (homeImmediately && loopIteration == 0)) {
-		justAligned = true;
-
-		// Sets the telescope to operating mode Mode::TRACKING
-		scope.setHomed(true);
-	}
-
-	// Turn the stepper motors on or off, depending on state of STEPPERS_ON_PIN
-	setSteppersOnOffState();
-
-	// Every UPDATE_MOTOR_POS_MS milliseconds, or when this is run the first time, 
-	// we calculate and update the target motor position of the telescope
-	if (millis() - last_motor_update >= UPDATE_MOTOR_POS_MS || first_loop_run) {
-		first_loop_run = false;
-		last_motor_update = millis();
-
-		#if defined(DEBUG) && defined(DEBUG_SERIAL_STEPPER_MOVEMENT) && defined(DEBUG_TIMING)
-			// Start timing the calculation
-			long micros_start = micros();
-		#endif
-
-		// This function converts the coordinates
-		scope.calculateMotorTargets();
-
-		// This actually makes the motors move to their desired target positions
-		#ifdef MOUNT_STOP_UNTIL_GPS_POS_VALID
-			if (observer.hasValidPosition()) {
-				scope.move();
-			}
-		#else
-			scope.move();
-		#endif
-
-		#if defined(DEBUG) && defined(DEBUG_SERIAL_STEPPER_MOVEMENT) && defined(DEBUG_TIMING)
-			// Debug: If a move took place, output how long it took from beginning to end of the calculation
-			if (scope._didMove) {
-				long calc_time = scope._lastCalcMicros - micros_start;
-				long dbg_time = micros() - scope._lastCalcMicros;
-				DEBUG_PRINT("; Calc: ");
-				DEBUG_PRINT(calc_time / 1000.);
-				DEBUG_PRINT("ms; DbgComms: ");
-				DEBUG_PRINT(dbg_time / 1000.);
-				DEBUG_PRINTLN("ms");
-			}
-		#endif
-	}
-
-	loopIteration++;
-}
\ No newline at end of file
+	const unsigned long loopStart = micros();
+	scheduler.runNext();
+	Profiler::recordLoop(micros() - loopStart);
+}
@@ -0,0 +1,234 @@
+#include "Arduino.h"
+#include "AccelStepper.h"
+
+AccelStepper::AccelStepper(uint8_t interface, uint8_t pin1, uint8_t pin2, uint8_t, uint8_t, bool enable) :
+	_interface(interface) {
+	_pin[0] = pin1;
+	_pin[1] = pin2;
+	if (enable) {
+		enableOutputs();
+	}
+	setAcceleration(1);
+}
+
+void AccelStepper::moveTo(long absolute) {
+	if (_targetPos != absolute) {
+		_targetPos = absolute;
+		computeNewSpeed();
+	}
+}
+
+void AccelStepper::move(long relative) {
+	moveTo(_currentPos + relative);
+}
+
+bool AccelStepper::runSpeed() {
+	if (!_stepInterval) {
+		return false;
+	}
+
+	const unsigned long time = micros();
+	if (time - _lastStepTime >= _stepInterval) {
+		if (_direction == DIRECTION_CW) {
+			_currentPos += 1;
+		}
+		else {
+			_currentPos -= 1;
+		}
+		step(_currentPos);
+		_lastStepTime = time;
+		return true;
+	}
+	return false;
+}
+
+bool AccelStepper::run() {
+	if (runSpeed()) {
+		computeNewSpeed();
+	}
+	return _speed != 0.0 || distanceToGo() != 0;
+}
+
+void AccelStepper::computeNewSpeed() {
+	const long distanceTo = distanceToGo();
+	const long stepsToStop = (long)((_speed * _speed) / (2.0 * _acceleration));
+
+	if (distanceTo == 0 && stepsToStop <= 1) {
+		// We are at the target and it's time to stop
+		_stepInterval = 0;
+		_speed = 0.0;
+		_n = 0;
+		return;
+	}
+
+	if (distanceTo > 0) {
+		// We are anticlockwise from the target and need to go clockwise
+		if (_n > 0) {
+			// Currently accelerating, need to decel now? Or maybe going the wrong way?
+			if ((stepsToStop >= distanceTo) || _direction == DIRECTION_CCW) {
+				_n = -stepsToStop;
+			}
+		}
+		else if (_n < 0) {
+			// Currently decelerating, need to accel again?
+			if ((stepsToStop < distanceTo) && _direction == DIRECTION_CW) {
+				_n = -_n;
+			}
+		}
+	}
+	else if (distanceTo < 0) {
+		// We are clockwise from the target and need to go anticlockwise
+		if (_n > 0) {
+			if ((stepsToStop >= -distanceTo) || _direction == DIRECTION_CW) {
+				_n = -stepsToStop;
+			}
+		}
+		else if (_n < 0) {
+			if ((stepsToStop < -distanceTo) && _direction == DIRECTION_CCW) {
+				_n = -_n;
+			}
+		}
+	}
+
+	if (_n == 0) {
+		// First step from stopped
+		_cn = _c0;
+		_direction = (distanceTo > 0) ? DIRECTION_CW : DIRECTION_CCW;
+	}
+	else {
+		// Subsequent step. Works for accel (n is +_ve) and decel (n is -ve).
+		_cn = _cn - ((2.0 * _cn) / ((4.0 * _n) + 1));
+		if (_cn < _cmin) {
+			_cn = _cmin;
+		}
+	}
+	_n++;
+	_stepInterval = _cn;
+	_speed = 1000000.0 / _cn;
+	if (_direction == DIRECTION_CCW) {
+		_speed = -_speed;
+	}
+}
+
+void AccelStepper::setMaxSpeed(float speed) {
+	if (speed < 0.0) {
+		speed = -speed;
+	}
+	if (_maxSpeed != speed) {
+		_maxSpeed = speed;
+		_cmin = 1000000.0 / speed;
+		// Recompute _n from current speed and adjust speed if accelerating or cruising
+		if (_n > 0) {
+			_n = (long)((_speed * _speed) / (2.0 * _acceleration));
+			computeNewSpeed();
+		}
+	}
+}
+
+float AccelStepper::maxSpeed() {
+	return _maxSpeed;
+}
+
+void AccelStepper::setAcceleration(float acceleration) {
+	if (acceleration == 0.0) {
+		return;
+	}
+	if (acceleration < 0.0) {
+		acceleration = -acceleration;
+	}
+	if (_acceleration != acceleration) {
+		// Recompute _n per Equation 17
+		_n = _n * (_acceleration / acceleration);
+		// New c0 per Equation 7, with correction per Equation 15
+		_c0 = 0.676 * sqrt(2.0 / acceleration) * 1000000.0;
+		_acceleration = acceleration;
+		computeNewSpeed();
+	}
+}
+
+void AccelStepper::setSpeed(float speed) {
+	if (speed == _speed) {
+		return;
+	}
+	speed = constrain(speed, -_maxSpeed, _maxSpeed);
+	if (speed == 0.0) {
+		_stepInterval = 0;
+	}
+	else {
+		_stepInterval = fabs(1000000.0 / speed);
+		_direction = (speed > 0.0) ? DIRECTION_CW : DIRECTION_CCW;
+	}
+	_speed = speed;
+}
+
+float AccelStepper::speed() {
+	return _speed;
+}
+
+long AccelStepper::distanceToGo() {
+	return _targetPos - _currentPos;
+}
+
+long AccelStepper::targetPosition() {
+	return _targetPos;
+}
+
+long AccelStepper::currentPosition() {
+	return _currentPos;
+}
+
+void AccelStepper::setCurrentPosition(long position) {
+	_targetPos = _currentPos = position;
+	_n = 0;
+	_stepInterval = 0;
+	_speed = 0.0;
+}
+
+void AccelStepper::stop() {
+	if (_speed != 0.0) {
+		const long stepsToStop = (long)((_speed * _speed) / (2.0 * _acceleration)) + 1;
+		if (_speed > 0) {
+			move(stepsToStop);
+		}
+		else {
+			move(-stepsToStop);
+		}
+	}
+}
+
+bool AccelStepper::isRunning() {
+	return !(_speed == 0.0 && _targetPos == _currentPos);
+}
+
+void AccelStepper::setMinPulseWidth(unsigned int minWidth) {
+	_minPulseWidth = minWidth;
+}
+
+void AccelStepper::setPinsInverted(bool directionInvert, bool stepInvert, bool enableInvert) {
+	_pinInverted[0] = stepInvert;
+	_pinInverted[1] = directionInvert;
+	_enableInverted = enableInvert;
+}
+
+void AccelStepper::enableOutputs() {
+	pinMode(_pin[0], OUTPUT);
+	pinMode(_pin[1], OUTPUT);
+}
+
+void AccelStepper::disableOutputs() {
+	setOutputPins(0);
+}
+
+void AccelStepper::setOutputPins(uint8_t mask) {
+	for (uint8_t i = 0; i < 2; i++) {
+		digitalWrite(_pin[i], (mask & (1 << i)) ? (HIGH ^ _pinInverted[i]) : (LOW ^ _pinInverted[i]));
+	}
+}
+
+// Like the library, this waits _minPulseWidth microseconds between the two edges
+void AccelStepper::step(long) {
+	setOutputPins(_direction ? 0b10 : 0b00);
+	setOutputPins(_direction ? 0b11 : 0b01);
+	delayMicroseconds(_minPulseWidth);
+	setOutputPins(_direction ? 0b10 : 0b00);
+}
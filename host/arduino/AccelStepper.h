@@ -0,0 +1,89 @@
+#pragma once
+/*
+ * AccelStepper.h
+ *
+ * Host replacement for Mike McCauley's AccelStepper library. It follows the same speed/acceleration
+ * algorithm (David Austin's stepper ramp equations), so that the CPU cost and the resulting step
+ * pattern of run() are comparable to the library used on the boards.
+ * Only the DRIVER interface is implemented. Step pulses are written to the simulated pins.
+ */
+
+// Like the library, this pulls in the Arduino core for everything that includes it
+#include "Arduino.h"
+
+class AccelStepper {
+public:
+	typedef enum {
+		FUNCTION  = 0,
+		DRIVER    = 1,
+		FULL2WIRE = 2,
+		FULL3WIRE = 3,
+		FULL4WIRE = 4,
+		HALF3WIRE = 6,
+		HALF4WIRE = 8
+	} MotorInterfaceType;
+
+	AccelStepper(uint8_t interface = AccelStepper::FULL4WIRE, uint8_t pin1 = 2, uint8_t pin2 = 3, uint8_t pin3 = 4, uint8_t pin4 = 5, bool enable = true);
+
+	void moveTo(long absolute);
+	void move(long relative);
+
+	bool run();
+	bool runSpeed();
+
+	void setMaxSpeed(float speed);
+	float maxSpeed();
+
+	void setAcceleration(float acceleration);
+
+	void setSpeed(float speed);
+	float speed();
+
+	long distanceToGo();
+	long targetPosition();
+	long currentPosition();
+	void setCurrentPosition(long position);
+
+	void stop();
+	bool isRunning();
+
+	void setMinPulseWidth(unsigned int minWidth);
+	void setPinsInverted(bool directionInvert = false, bool stepInvert = false, bool enableInvert = false);
+
+	void enableOutputs();
+	void disableOutputs();
+
+protected:
+	typedef enum {
+		DIRECTION_CCW = 0,
+		DIRECTION_CW  = 1
+	} Direction;
+
+	void computeNewSpeed();
+	void setOutputPins(uint8_t mask);
+	void step(long step);
+
+	bool _direction = DIRECTION_CCW;
+
+private:
+	uint8_t _interface;
+	uint8_t _pin[2];
+	bool _pinInverted[2] = { false, false };
+	bool _enableInverted = false;
+
+	long _currentPos = 0;
+	long _targetPos = 0;
+	float _speed = 0.0;
+	float _maxSpeed = 1.0;
+	float _acceleration = 0.0;
+	float _sqrt_twoa = 1.0;
+	unsigned long _stepInterval = 0;
+	unsigned int _minPulseWidth = 1;
+	unsigned long _lastStepTime = 0;
+
+	// Ramp state. See the AccelStepper documentation for how these work
+	long _n = 0;
+	float _c0 = 0.0;
+	float _cn = 0.0;
+	float _cmin = 1.0;
+};
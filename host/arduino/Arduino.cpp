@@ -0,0 +1,101 @@
+#include <chrono>
+#include <thread>
+
+#include "Arduino.h"
+
+namespace {
+	// Offset added by hostAdvanceClock()
+	unsigned long long clockOffsetMicros = 0;
+
+	// Set by hostStopClock(). The clock then only moves with hostAdvanceClock(), delay() and delayMicroseconds()
+	bool clockStopped = false;
+	unsigned long long stoppedMicros = 0;
+
+	uint8_t pinModes[HOST_NUM_PINS];
+	uint8_t pinLevels[HOST_NUM_PINS];
+
+	unsigned long digitalWrites = 0;
+
+	unsigned long long elapsedMicros() {
+		if (clockStopped) {
+			return stoppedMicros + clockOffsetMicros;
+		}
+		// Set by the first call, so that the constructors of global objects (like the ones of the sketch) can use the clock as well
+		static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		const auto elapsed = std::chrono::steady_clock::now() - startTime;
+		return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + clockOffsetMicros;
+	}
+}
+
+unsigned long millis() {
+	return static_cast<unsigned long>(elapsedMicros() / 1000);
+}
+
+unsigned long micros() {
+	return static_cast<unsigned long>(elapsedMicros());
+}
+
+void delay(unsigned long ms) {
+	if (clockStopped) {
+		clockOffsetMicros += ms * 1000ULL;
+		return;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// A busy loop, like on the boards. Sleeping would take tens of microseconds longer than asked for
+void delayMicroseconds(unsigned int us) {
+	if (clockStopped) {
+		clockOffsetMicros += us;
+		return;
+	}
+	const auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+	while (std::chrono::steady_clock::now() < end) {
+	}
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+	if (pin < HOST_NUM_PINS) {
+		pinModes[pin] = mode;
+		// Pullups make an unconnected input read HIGH
+		if (mode == INPUT_PULLUP) {
+			pinLevels[pin] = HIGH;
+		}
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+	digitalWrites++;
+	if (pin < HOST_NUM_PINS) {
+		pinLevels[pin] = value ? HIGH : LOW;
+	}
+}
+
+int digitalRead(uint8_t pin) {
+	return pin < HOST_NUM_PINS ? pinLevels[pin] : LOW;
+}
+
+// There is no interrupt context on the host. The stepper ISR is called from the same thread as loop()
+void noInterrupts() {}
+void interrupts() {}
+
+void hostAdvanceClock(unsigned long microseconds) {
+	clockOffsetMicros += microseconds;
+}
+
+void hostStopClock() {
+	if (!clockStopped) {
+		stoppedMicros = elapsedMicros() - clockOffsetMicros;
+		clockStopped = true;
+	}
+}
+
+void hostSetPinLevel(uint8_t pin, uint8_t value) {
+	if (pin < HOST_NUM_PINS) {
+		pinLevels[pin] = value ? HIGH : LOW;
+	}
+}
+
+unsigned long hostDigitalWriteCount() {
+	return digitalWrites;
+}
@@ -0,0 +1,82 @@
+#pragma once
+/*
+ * Arduino.h
+ *
+ * Host replacement for the Arduino core. It only provides what the firmware actually uses,
+ * so that the mount, observer and communication code can be compiled and benchmarked on a PC.
+ * Pins are simulated in memory and time is taken from the host's monotonic clock.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "WString.h"
+#include "Print.h"
+#include "HardwareSerial.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define LED_BUILTIN 13
+
+#define PI         3.1415926535897932384626433832795
+#define HALF_PI    1.5707963267948966192313216916398
+#define TWO_PI     6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define radians(deg) ((deg)*DEG_TO_RAD)
+#define degrees(rad) ((rad)*RAD_TO_DEG)
+#define constrain(amt, low, high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+// The host has a single address space, like the Due, whose core defines these the same way
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_float(address) (*(const float*)(address))
+
+// Number of simulated digital pins. The Arduino Mega and Due both have less than this
+#define HOST_NUM_PINS 128
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+void noInterrupts();
+void interrupts();
+
+
+/*
+ * Host build only
+ * These have no equivalent on the boards. They allow the benchmark and tools to control the simulated hardware
+ */
+
+// Moves the clock used by millis() and micros() forward. Useful to skip the startup phase of the mounts
+void hostAdvanceClock(unsigned long microseconds);
+
+// Stops the clock where it is. From then on, only hostAdvanceClock() and the delay functions move it,
+// so that a test sees the same times however fast or busy the host is
+void hostStopClock();
+
+// Sets the level an input pin reports on the next digitalRead()
+void hostSetPinLevel(uint8_t pin, uint8_t value);
+
+// Number of times digitalWrite() has been called since startup
+unsigned long hostDigitalWriteCount();
@@ -0,0 +1,50 @@
+#pragma once
+/*
+ * EEPROM.h
+ *
+ * Host replacement for the EEPROM library of the AVR core. The 4KB of the Arduino Mega are kept in memory.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define HOST_EEPROM_SIZE 4096
+
+class EEPROMClass {
+public:
+	uint8_t read(int address) {
+		return _data[address];
+	}
+
+	void write(int address, uint8_t value) {
+		_data[address] = value;
+	}
+
+	void update(int address, uint8_t value) {
+		if (_data[address] != value) {
+			_data[address] = value;
+		}
+	}
+
+	template<typename T>
+	T& get(int address, T& value) {
+		memcpy(&value, &_data[address], sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	const T& put(int address, const T& value) {
+		memcpy(&_data[address], &value, sizeof(T));
+		return value;
+	}
+
+	uint16_t length() {
+		return HOST_EEPROM_SIZE;
+	}
+
+private:
+	uint8_t _data[HOST_EEPROM_SIZE] = {};
+};
+
+// Unlike the AVR core this is not a static in the header. There must only be one EEPROM
+extern EEPROMClass EEPROM;
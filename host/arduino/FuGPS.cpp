@@ -0,0 +1,23 @@
+#include "Arduino.h"
+#include "FuGPS.h"
+
+bool FuGPS::read() {
+	bool sentence = false;
+	while (_stream.available() > 0) {
+		if (_stream.read() == '\n') {
+			sentence = true;
+			_lastRead = millis();
+		}
+	}
+	return sentence;
+}
+
+bool FuGPS::isAlive(unsigned int timeout) {
+	return _lastRead != 0 && millis() - _lastRead < timeout;
+}
+
+void FuGPS::sendCommand(const char* command) {
+	_stream.print('$');
+	_stream.print(command);
+	_stream.println();
+}
@@ -0,0 +1,48 @@
+#pragma once
+/*
+ * FuGPS.h
+ *
+ * Host replacement for the FuGPS library. It does not parse NMEA sentences. read() consumes
+ * whatever was sent to the GPS serial port and reports a sentence for every line ending it sees.
+ * The public fields can be set directly by the host program to simulate a fix.
+ */
+
+// Like the library, this pulls in the Arduino core for everything that includes it
+#include "Arduino.h"
+
+#define FUGPS_PMTK_SET_NMEA_BAUDRATE_9600      "PMTK251,9600"
+#define FUGPS_PMTK_SET_NMEA_UPDATERATE_1HZ     "PMTK220,1000"
+#define FUGPS_PMTK_API_SET_NMEA_OUTPUT_DEFAULT "PMTK314,-1"
+#define FUGPS_PMTK_API_SET_NMEA_OUTPUT_RMCGGA  "PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0"
+
+class FuGPS {
+public:
+	FuGPS(Stream& stream) : _stream(stream) {}
+
+	bool read();
+
+	bool hasFix() {
+		return Quality > 0;
+	}
+
+	bool isAlive(unsigned int timeout = 10000);
+
+	void sendCommand(const char* command);
+
+	uint8_t Hours = 0, Minutes = 0;
+	float Seconds = 0;
+	uint8_t Days = 0, Months = 0;
+	uint16_t Years = 0;
+
+	uint8_t Quality = 0;
+	uint8_t Satellites = 0;
+
+	float Accuracy = 0;
+	float Altitude = 0;
+	float Latitude = 0;
+	float Longitude = 0;
+
+private:
+	Stream& _stream;
+	unsigned long _lastRead = 0;
+};
@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "HardwareSerial.h"
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+HardwareSerial Serial2;
+HardwareSerial Serial3;
+
+int HardwareSerial::available() {
+	return static_cast<int>(_rx.size() - _rxPosition);
+}
+
+int HardwareSerial::read() {
+	if (_rxPosition >= _rx.size()) {
+		return -1;
+	}
+	const int value = static_cast<uint8_t>(_rx[_rxPosition++]);
+
+	// Drop the consumed part once everything was read, so the buffer does not grow forever
+	if (_rxPosition == _rx.size()) {
+		_rx.clear();
+		_rxPosition = 0;
+	}
+	return value;
+}
+
+int HardwareSerial::peek() {
+	if (_rxPosition >= _rx.size()) {
+		return -1;
+	}
+	return static_cast<uint8_t>(_rx[_rxPosition]);
+}
+
+size_t HardwareSerial::write(uint8_t value) {
+	_bytesWritten++;
+	if (_capture) {
+		_tx.push_back(static_cast<char>(value));
+	}
+	if (_echo) {
+		putchar(value);
+	}
+	return 1;
+}
+
+void HardwareSerial::hostInject(const char* data) {
+	hostInject(reinterpret_cast<const uint8_t*>(data), strlen(data));
+}
+
+void HardwareSerial::hostInject(const uint8_t* data, size_t size) {
+	_rx.append(reinterpret_cast<const char*>(data), size);
+}
+
+std::string HardwareSerial::hostTakeOutput() {
+	std::string output;
+	output.swap(_tx);
+	return output;
+}
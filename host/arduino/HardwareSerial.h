@@ -0,0 +1,87 @@
+#pragma once
+/*
+ * HardwareSerial.h
+ *
+ * Host replacement for the Arduino serial ports. Received bytes are injected by the host program,
+ * sent bytes are counted and can optionally be captured or echoed to stdout.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include "Print.h"
+
+// Size of the RX/TX buffers of the hardware serial ports on the Arduino Mega
+#define SERIAL_RX_BUFFER_SIZE 64
+#define SERIAL_TX_BUFFER_SIZE 64
+
+class HardwareSerial : public Stream {
+public:
+	void begin(unsigned long baud) {
+		_baud = baud;
+	}
+
+	void end() {}
+
+	int available();
+	int read();
+	int peek();
+
+	// The host port never blocks, so there is always the whole hardware buffer available
+	int availableForWrite() {
+		return SERIAL_TX_BUFFER_SIZE - 1;
+	}
+
+	void flush() {}
+
+	size_t write(uint8_t value);
+	using Print::write;
+
+	operator bool() {
+		return true;
+	}
+
+
+	/*
+	 * Host build only
+	 */
+
+	// Appends bytes to the receive buffer, as if they were sent by the connected device. Unlike the
+	// hardware buffer this one does not overflow, so whole command bursts can be queued at once
+	void hostInject(const char* data);
+	void hostInject(const uint8_t* data, size_t size);
+
+	// If enabled, every byte written to the port is stored and can be fetched with hostTakeOutput()
+	void hostCapture(bool enabled) {
+		_capture = enabled;
+	}
+
+	// If enabled, every byte written to the port is also written to stdout
+	void hostEcho(bool enabled) {
+		_echo = enabled;
+	}
+
+	// Returns and clears the captured output
+	std::string hostTakeOutput();
+
+	// Number of bytes written to the port since startup
+	unsigned long hostBytesWritten() const {
+		return _bytesWritten;
+	}
+
+private:
+	unsigned long _baud = 0;
+	unsigned long _bytesWritten = 0;
+	bool _capture = false;
+	bool _echo = false;
+
+	std::string _rx;
+	size_t _rxPosition = 0;
+	std::string _tx;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+extern HardwareSerial Serial3;
@@ -0,0 +1,11 @@
+#pragma once
+/*
+ * MultiStepper.h
+ *
+ * The firmware includes this header from the AccelStepper library, but does not use the class.
+ */
+
+#include "AccelStepper.h"
+
+class MultiStepper {
+};
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "Print.h"
+
+namespace {
+	// Formats an integer into a stack buffer, so that printing numbers does not allocate like String does
+	size_t printNumber(Print& out, unsigned long value, bool negative, int base) {
+		if (base < 2) {
+			base = 10;
+		}
+		char buffer[8 * sizeof(long) + 2];
+		char* str = &buffer[sizeof(buffer) - 1];
+		*str = '\0';
+		do {
+			const char c = static_cast<char>(value % base);
+			value /= base;
+			*--str = c < 10 ? c + '0' : c + 'A' - 10;
+		} while (value);
+		if (negative) {
+			*--str = '-';
+		}
+		return out.write(str);
+	}
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+	size_t n = 0;
+	while (size--) {
+		n += write(*buffer++);
+	}
+	return n;
+}
+
+size_t Print::write(const char* str) {
+	if (str == nullptr) {
+		return 0;
+	}
+	return write(reinterpret_cast<const uint8_t*>(str), strlen(str));
+}
+
+size_t Print::print(const String& value) {
+	return write(value.c_str());
+}
+
+size_t Print::print(const char* value) {
+	return write(value);
+}
+
+size_t Print::print(char value) {
+	return write(static_cast<uint8_t>(value));
+}
+
+size_t Print::print(unsigned char value, int base) {
+	return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(int value, int base) {
+	return print(static_cast<long>(value), base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+	return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(long value, int base) {
+	if (value < 0 && base == 10) {
+		return printNumber(*this, 0UL - static_cast<unsigned long>(value), true, base);
+	}
+	return printNumber(*this, static_cast<unsigned long>(value), false, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+	return printNumber(*this, value, false, base);
+}
+
+size_t Print::print(double value, int digits) {
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+	return write(buffer);
+}
+
+size_t Print::println() {
+	return write("\r\n");
+}
+
+size_t Print::println(const String& value) {
+	return print(value) + println();
+}
+
+size_t Print::println(const char* value) {
+	return print(value) + println();
+}
+
+size_t Print::println(char value) {
+	return print(value) + println();
+}
+
+size_t Print::println(unsigned char value, int base) {
+	return print(value, base) + println();
+}
+
+size_t Print::println(int value, int base) {
+	return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base) {
+	return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base) {
+	return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base) {
+	return print(value, base) + println();
+}
+
+size_t Print::println(double value, int digits) {
+	return print(value, digits) + println();
+}
@@ -0,0 +1,3 @@
+#pragma once
+// The Time library provides this header for compatibility with old sketches
+#include "TimeLib.h"
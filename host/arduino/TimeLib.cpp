@@ -0,0 +1,89 @@
+#include "Arduino.h"
+#include "TimeLib.h"
+
+namespace {
+	// Seconds since 1970 at the time prevMillis was taken
+	time_t sysTime = 0;
+	unsigned long prevMillis = 0;
+
+	struct CalendarTime {
+		int year;
+		int month;
+		int day;
+		int hour;
+		int minute;
+		int second;
+		int weekday; // 1 = Sunday
+	};
+
+	// Days since 1970-01-01 of a civil date (proleptic gregorian calendar)
+	long daysFromCivil(int y, int m, int d) {
+		y -= m <= 2;
+		const long era = (y >= 0 ? y : y - 399) / 400;
+		const long yoe = y - era * 400;
+		const long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+		const long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+		return era * 146097 + doe - 719468;
+	}
+
+	CalendarTime breakTime(time_t t) {
+		CalendarTime tm;
+		long days = static_cast<long>(t / 86400);
+		long secs = static_cast<long>(t % 86400);
+		if (secs < 0) {
+			secs += 86400;
+			days--;
+		}
+		tm.hour = static_cast<int>(secs / 3600);
+		tm.minute = static_cast<int>(secs / 60 % 60);
+		tm.second = static_cast<int>(secs % 60);
+		tm.weekday = static_cast<int>(((days % 7) + 11) % 7) + 1; // 1970-01-01 was a thursday
+
+		days += 719468;
+		const long era = (days >= 0 ? days : days - 146096) / 146097;
+		const long doe = days - era * 146097;
+		const long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+		const long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+		const long mp = (5 * doy + 2) / 153;
+		tm.day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+		tm.month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+		tm.year = static_cast<int>(yoe + era * 400 + (tm.month <= 2));
+		return tm;
+	}
+}
+
+void setTime(time_t t) {
+	sysTime = t;
+	prevMillis = millis();
+}
+
+void setTime(int hr, int min, int sec, int dy, int mnth, int yr) {
+	// The Time library accepts two digit years as offset from 2000
+	if (yr < 100) {
+		yr += 2000;
+	}
+	setTime(static_cast<time_t>(daysFromCivil(yr, mnth, dy)) * 86400 + hr * 3600L + min * 60L + sec);
+}
+
+time_t now() {
+	while (millis() - prevMillis >= 1000) {
+		sysTime++;
+		prevMillis += 1000;
+	}
+	return sysTime;
+}
+
+int hour() { return hour(now()); }
+int hour(time_t t) { return breakTime(t).hour; }
+int minute() { return minute(now()); }
+int minute(time_t t) { return breakTime(t).minute; }
+int second() { return second(now()); }
+int second(time_t t) { return breakTime(t).second; }
+int day() { return day(now()); }
+int day(time_t t) { return breakTime(t).day; }
+int weekday() { return weekday(now()); }
+int weekday(time_t t) { return breakTime(t).weekday; }
+int month() { return month(now()); }
+int month(time_t t) { return breakTime(t).month; }
+int year() { return year(now()); }
+int year(time_t t) { return breakTime(t).year; }
@@ -0,0 +1,29 @@
+#pragma once
+/*
+ * TimeLib.h
+ *
+ * Host replacement for Paul Stoffregen's Time library. Like the original, the system time is
+ * kept in seconds since 1970 and advanced from millis() every time now() is called.
+ */
+
+#include <time.h>
+
+void setTime(time_t t);
+void setTime(int hr, int min, int sec, int day, int month, int yr);
+
+time_t now();
+
+int hour();
+int hour(time_t t);
+int minute();
+int minute(time_t t);
+int second();
+int second(time_t t);
+int day();
+int day(time_t t);
+int weekday();
+int weekday(time_t t);
+int month();
+int month(time_t t);
+int year();
+int year(time_t t);
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "WString.h"
+
+namespace {
+	// Formats an integer in the given base, the same way Arduino's String(int, base) does
+	std::string integerToString(unsigned long value, bool negative, unsigned char base) {
+		if (base < 2 || base > 36) {
+			base = 10;
+		}
+		char buffer[8 * sizeof(long) + 2];
+		char* str = &buffer[sizeof(buffer) - 1];
+		*str = '\0';
+		do {
+			const char c = static_cast<char>(value % base);
+			value /= base;
+			*--str = c < 10 ? c + '0' : c + 'A' - 10;
+		} while (value);
+		if (negative) {
+			*--str = '-';
+		}
+		return std::string(str);
+	}
+
+	std::string signedToString(long value, unsigned char base) {
+		if (value < 0 && base == 10) {
+			return integerToString(0UL - static_cast<unsigned long>(value), true, base);
+		}
+		return integerToString(static_cast<unsigned long>(value), false, base);
+	}
+
+	std::string floatToString(double value, unsigned char decimalPlaces) {
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+		return std::string(buffer);
+	}
+}
+
+String::String(const char* value) : _buffer(value ? value : "") {}
+String::String(const std::string& value) : _buffer(value) {}
+String::String(char value) : _buffer(1, value) {}
+String::String(unsigned char value, unsigned char base) : _buffer(integerToString(value, false, base)) {}
+String::String(int value, unsigned char base) : _buffer(signedToString(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _buffer(integerToString(value, false, base)) {}
+String::String(long value, unsigned char base) : _buffer(signedToString(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _buffer(integerToString(value, false, base)) {}
+String::String(float value, unsigned char decimalPlaces) : _buffer(floatToString(value, decimalPlaces)) {}
+String::String(double value, unsigned char decimalPlaces) : _buffer(floatToString(value, decimalPlaces)) {}
+
+String operator+(const String& lhs, const String& rhs) {
+	return String(lhs._buffer + rhs._buffer);
+}
+
+String operator+(const String& lhs, const char* rhs) {
+	return String(lhs._buffer + rhs);
+}
+
+String operator+(const char* lhs, const String& rhs) {
+	return String(lhs + rhs._buffer);
+}
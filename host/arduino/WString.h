@@ -0,0 +1,47 @@
+#pragma once
+/*
+ * WString.h
+ *
+ * Host replacement for the Arduino String class. Like the original it allocates on the heap,
+ * so the benchmark can count the allocations caused by String usage in the firmware.
+ */
+
+#include <string>
+
+class String {
+public:
+	String(const char* value = "");
+	String(const std::string& value);
+	explicit String(char value);
+	explicit String(unsigned char value, unsigned char base = 10);
+	explicit String(int value, unsigned char base = 10);
+	explicit String(unsigned int value, unsigned char base = 10);
+	explicit String(long value, unsigned char base = 10);
+	explicit String(unsigned long value, unsigned char base = 10);
+	explicit String(float value, unsigned char decimalPlaces = 2);
+	explicit String(double value, unsigned char decimalPlaces = 2);
+
+	unsigned int length() const {
+		return static_cast<unsigned int>(_buffer.length());
+	}
+
+	const char* c_str() const {
+		return _buffer.c_str();
+	}
+
+	String& operator+=(const String& rhs) {
+		_buffer += rhs._buffer;
+		return *this;
+	}
+
+	bool operator==(const String& rhs) const {
+		return _buffer == rhs._buffer;
+	}
+
+	friend String operator+(const String& lhs, const String& rhs);
+	friend String operator+(const String& lhs, const char* rhs);
+	friend String operator+(const char* lhs, const String& rhs);
+
+private:
+	std::string _buffer;
+};
@@ -0,0 +1,754 @@
+/*
+ * benchmark.cpp
+ *
+ * Microbenchmarks for the hot paths of the firmware, built by the host build (see CMakeLists.txt).
+ * Every benchmark reports the time per call, the heap allocations per call and how many bytes
+ * per call were written to the Stellarium/debug serial port.
+ *
+ * After the benchmarks it reports the accuracy of every numeric policy (see NumericPolicy.h)
+ * and how many stepper interrupts each stepper class needs per second.
+ *
+ * Usage: dobson_bench [filter]
+ * Only benchmarks and reports whose name contains the filter are run.
+ */
+#include <chrono>
+#include <math.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <AccelStepper.h>
+
+#include "config.h"
+#include "CoordinateEngine.h"
+#include "conversion.h"
+#include "display_unit.h"
+#include "location.h"
+#include "Dobson.h"
+#include "FixedObserver.h"
+#include "NumericPolicy.h"
+#include "Profiler.h"
+#include "Scheduler.h"
+#include "SerialOutput.h"
+#include "SlewPlanner.h"
+#include "StepGenerator.h"
+#include "Telemetry.h"
+#include "TrigTables.h"
+#include "Trajectory.h"
+
+
+/*
+ * Allocation counting
+ * Every allocation of the program goes through these, including the ones made by String
+ */
+static unsigned long allocationCount = 0;
+
+void* operator new(size_t size) {
+	allocationCount++;
+	void* ptr = malloc(size ? size : 1);
+	if (ptr == nullptr) {
+		abort();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+
+// Results are written here, so that the compiler can not remove the benchmarked calls
+volatile double sink;
+
+// Only benchmarks containing this string are run
+static const char* benchmarkFilter = nullptr;
+
+// How long each benchmark runs
+static const std::chrono::nanoseconds benchmarkDuration = std::chrono::milliseconds(250);
+
+/*
+ * Runs fn in batches until benchmarkDuration has passed and prints the results.
+ * fn gets the index of the current call, which the benchmarks use to vary their inputs
+ */
+static bool isSelected(const char* name) {
+	return benchmarkFilter == nullptr || strstr(name, benchmarkFilter) != nullptr;
+}
+
+template<typename Function>
+void runBenchmark(const char* name, Function fn) {
+	if (!isSelected(name)) {
+		return;
+	}
+
+	// Warm up caches and let lazily initialized state settle
+	for (unsigned long i = 0; i < 100; i++) {
+		fn(i);
+	}
+
+	const unsigned long allocationsBefore = allocationCount;
+	const unsigned long bytesBefore = Serial.hostBytesWritten();
+	const auto start = std::chrono::steady_clock::now();
+
+	unsigned long calls = 0;
+	std::chrono::nanoseconds elapsed(0);
+	unsigned long batch = 16;
+	while (elapsed < benchmarkDuration) {
+		for (unsigned long i = 0; i < batch; i++) {
+			fn(calls + i);
+		}
+		calls += batch;
+		elapsed = std::chrono::steady_clock::now() - start;
+		if (batch < 65536) {
+			batch *= 2;
+		}
+	}
+
+	const double nsPerCall = static_cast<double>(elapsed.count()) / calls;
+	const double allocationsPerCall = static_cast<double>(allocationCount - allocationsBefore) / calls;
+	const double bytesPerCall = static_cast<double>(Serial.hostBytesWritten() - bytesBefore) / calls;
+
+	printf("%-56s %12.1f %12.3f %12.1f %12lu\n", name, nsPerCall, allocationsPerCall, bytesPerCall, calls);
+}
+
+
+// A few targets spread over the sky, so that the trig functions do not always get the same arguments
+static const RaDecPosition targets[] = {
+	{ 250.425, 36.466667 },
+	{ 279.2354166, 38.78555556 }, // Vega
+	{ 213.9083333, 19.17038889 }, // Arktur
+	{ 37.9624166, 89.2642777 },   // Polaris
+	{ 101.2875, -16.7161 },       // Sirius
+	{ 88.7929, 7.4071 },          // Betelgeuse
+	{ 310.3579, 45.2803 },        // Deneb
+	{ 152.0929, 11.9672 }         // Regulus
+};
+static const unsigned int targetCount = sizeof(targets) / sizeof(targets[0]);
+
+// Feeds complete commands to the Stellarium port and runs handleSerialCommunication() until they were processed
+static void runSerialCommand(Dobson& scope, Observer& observer, const char* command) {
+	Serial.hostInject(command);
+	while (Serial.available() > 0) {
+		handleSerialCommunication(scope, observer);
+	}
+	// A command that switched to tracking leaves the ones after it queued for the next call
+	handleSerialCommunication(scope, observer);
+}
+
+
+// Task for the scheduler benchmark, which only measures the scheduling
+static void benchTask() {
+}
+
+
+/*
+ * The batch benchmarks convert a whole catalog of catalogSize targets per call
+ */
+static const unsigned int catalogSize = 256;
+
+static void fillCatalog(RaDecPosition* catalog) {
+	for (unsigned int i = 0; i < catalogSize; i++) {
+		catalog[i] = { (i * 137.508) - 360. * static_cast<int>(i * 137.508 / 360.), (i % 170) - 85. };
+	}
+}
+
+template<typename Policy>
+static void benchmarkCoordinateEngine(Observer& observer) {
+	typedef BasicCoordinateEngine<Policy> Engine;
+	typedef typename Policy::Real Real;
+
+	char name[64];
+	#define POLICY_BENCHMARK_NAME(benchmark) (snprintf(name, sizeof(name), "CoordinateEngine<%s>/" benchmark, Policy::name()), name)
+
+	Engine engine;
+	runBenchmark(POLICY_BENCHMARK_NAME("update"), [&](unsigned long i) {
+		engine.update(observer.localSiderealTime() + (i & 1), observer.trigonometry());
+	});
+
+	static RaDecPosition catalog[catalogSize];
+	static AzAlt<Real> catalogHorizontal[catalogSize];
+	static Real catalogX[catalogSize], catalogY[catalogSize], catalogZ[catalogSize];
+	static Real catalogNorth[catalogSize], catalogEast[catalogSize], catalogUp[catalogSize];
+	fillCatalog(catalog);
+	for (unsigned int i = 0; i < catalogSize; i++) {
+		const typename Engine::Vector v = Engine::equatorialVector(catalog[i]);
+		catalogX[i] = v.x;
+		catalogY[i] = v.y;
+		catalogZ[i] = v.z;
+	}
+	engine.update(observer.localSiderealTime(), observer.trigonometry());
+
+	runBenchmark(POLICY_BENCHMARK_NAME("toHorizontal(vector)"), [&](unsigned long i) {
+		const AzAlt<Real> result = engine.toHorizontal(typename Engine::Vector{ catalogX[i % catalogSize], catalogY[i % catalogSize], catalogZ[i % catalogSize] });
+		sink = result.azimuth + result.altitude;
+	});
+
+	runBenchmark(POLICY_BENCHMARK_NAME("toEquatorial"), [&](unsigned long i) {
+		const RaDecPosition result = engine.toEquatorial({ static_cast<Real>(catalog[i % catalogSize].rightAscension), static_cast<Real>(catalog[i % catalogSize].declination) });
+		sink = result.rightAscension + result.declination;
+	});
+
+	runBenchmark(POLICY_BENCHMARK_NAME("toHorizontal[256]"), [&](unsigned long) {
+		engine.toHorizontal(catalog, catalogHorizontal, catalogSize);
+		sink = catalogHorizontal[0].altitude;
+	});
+
+	runBenchmark(POLICY_BENCHMARK_NAME("rotateToHorizontal[256]"), [&](unsigned long) {
+		engine.rotateToHorizontal(catalogX, catalogY, catalogZ, catalogNorth, catalogEast, catalogUp, catalogSize);
+		sink = catalogUp[0];
+	});
+
+	const typename Policy::StepScale scale = Policy::stepScale(AZ_STEPS_PER_DEG);
+	runBenchmark(POLICY_BENCHMARK_NAME("toSteps+toDegrees"), [&](unsigned long i) {
+		const long steps = Policy::toSteps(catalogHorizontal[i % catalogSize].azimuth, scale);
+		sink = Policy::toDegrees(steps, scale);
+	});
+
+	#undef POLICY_BENCHMARK_NAME
+}
+
+
+/*
+ * Stepper interrupt
+ * These are the bodies of moveSteppers() in dobson-star-tracker.ino, with either stepper class MountStepper can be.
+ * Every call is one interrupt. It returns the microseconds until the next interrupt, and the simulated clock is advanced by that,
+ * because AccelStepper times its steps with micros(). Interrupts with a step include the minimum pulse width of 1 microsecond
+ */
+
+// Without STEP_GENERATOR: AccelStepper, every STEPPER_INTERRUPT_FREQ microseconds
+struct AccelStepperInterrupt {
+	AccelStepper azimuth;
+	AccelStepper altitude;
+
+	AccelStepperInterrupt() : azimuth(AccelStepper::DRIVER, AZ_STEP_PIN, AZ_DIR_PIN), altitude(AccelStepper::DRIVER, ALT_STEP_PIN, ALT_DIR_PIN) {}
+
+	static const char* name() {
+		return "AccelStepper";
+	}
+
+	unsigned long run() {
+		azimuth.run();
+		altitude.run();
+		return STEPPER_INTERRUPT_FREQ;
+	}
+
+	unsigned long runSpeed() {
+		azimuth.runSpeed();
+		altitude.runSpeed();
+		return STEPPER_INTERRUPT_FREQ;
+	}
+};
+
+// With STEP_GENERATOR: StepGenerator, scheduled for the next step of either stepper (like scheduleStepperInterrupt())
+struct StepGeneratorInterrupt {
+	StepGenerator azimuth;
+	StepGenerator altitude;
+	unsigned long elapsed = STEPPER_INTERRUPT_FREQ;
+
+	StepGeneratorInterrupt() : azimuth(StepperPins<AZ_STEP_PIN, AZ_DIR_PIN>{}), altitude(StepperPins<ALT_STEP_PIN, ALT_DIR_PIN>{}) {}
+
+	static const char* name() {
+		return "StepGenerator";
+	}
+
+	unsigned long schedule(const unsigned long azimuthWait, const unsigned long altitudeWait) {
+		const unsigned long wait = azimuthWait < altitudeWait ? azimuthWait : altitudeWait;
+		elapsed = constrain(wait, STEP_TIMER_MIN_MICROS, STEP_TIMER_MAX_MICROS);
+		return elapsed;
+	}
+
+	unsigned long run() {
+		const unsigned long azimuthWait = azimuth.run(elapsed);
+		return schedule(azimuthWait, altitude.run(elapsed));
+	}
+
+	unsigned long runSpeed() {
+		const unsigned long azimuthWait = azimuth.runSpeed(elapsed);
+		return schedule(azimuthWait, altitude.runSpeed(elapsed));
+	}
+};
+
+template<typename Interrupt>
+static void setupStepInterrupt(Interrupt& interrupt) {
+	interrupt.azimuth.setMaxSpeed(AZ_MAX_SPEED);
+	interrupt.azimuth.setAcceleration(AZ_MAX_ACCEL);
+	interrupt.altitude.setMaxSpeed(ALT_MAX_SPEED);
+	interrupt.altitude.setAcceleration(ALT_MAX_ACCEL);
+}
+
+// Sidereal rate in steps per second, about one step per 70 ms
+static const float siderealStepRate = 14.f;
+
+template<typename Interrupt>
+static void benchmarkStepInterrupt() {
+	char name[64];
+	#define STEPPER_BENCHMARK_NAME(benchmark) (snprintf(name, sizeof(name), "moveSteppers<%s>/" benchmark, Interrupt::name()), name)
+
+	Interrupt interrupt;
+	setupStepInterrupt(interrupt);
+
+	runBenchmark(STEPPER_BENCHMARK_NAME("idle"), [&](unsigned long) {
+		hostAdvanceClock(interrupt.run());
+	});
+
+	interrupt.azimuth.moveTo(100000000L);
+	interrupt.altitude.moveTo(100000000L);
+	runBenchmark(STEPPER_BENCHMARK_NAME("slewing"), [&](unsigned long) {
+		hostAdvanceClock(interrupt.run());
+	});
+
+	interrupt.azimuth.setSpeed(siderealStepRate);
+	interrupt.altitude.setSpeed(-siderealStepRate);
+	runBenchmark(STEPPER_BENCHMARK_NAME("runSpeed"), [&](unsigned long) {
+		hostAdvanceClock(interrupt.runSpeed());
+	});
+
+	#undef STEPPER_BENCHMARK_NAME
+}
+
+
+// Set once a stepper interrupt rate was printed
+static bool interruptRateReported = false;
+
+/*
+ * Interrupts and steps per second of both steppers together, during the first 10 seconds of a slew from standstill
+ * and while both steppers run at the sidereal rate
+ */
+template<typename Interrupt>
+static void reportStepInterruptRate() {
+	char name[64];
+	snprintf(name, sizeof(name), "interrupt rate/%s", Interrupt::name());
+	if (!isSelected(name)) {
+		return;
+	}
+	if (!interruptRateReported) {
+		printf("\n%-56s %12s %12s %12s %12s\n", "stepper interrupts per second", "slewing", "steps", "sidereal", "steps");
+		interruptRateReported = true;
+	}
+
+	const unsigned long duration = 10000000UL;
+	unsigned long slewInterrupts = 0;
+	unsigned long siderealInterrupts = 0;
+	long slewSteps;
+	long siderealSteps;
+
+	Interrupt interrupt;
+	setupStepInterrupt(interrupt);
+	interrupt.azimuth.moveTo(100000000L);
+	interrupt.altitude.moveTo(100000000L);
+	for (unsigned long elapsed = 0; elapsed < duration; slewInterrupts++) {
+		const unsigned long wait = interrupt.run();
+		hostAdvanceClock(wait);
+		elapsed += wait;
+	}
+	slewSteps = interrupt.azimuth.currentPosition() + interrupt.altitude.currentPosition();
+
+	interrupt.azimuth.setCurrentPosition(0);
+	interrupt.altitude.setCurrentPosition(0);
+	interrupt.azimuth.setSpeed(siderealStepRate);
+	interrupt.altitude.setSpeed(siderealStepRate);
+	for (unsigned long elapsed = 0; elapsed < duration; siderealInterrupts++) {
+		const unsigned long wait = interrupt.runSpeed();
+		hostAdvanceClock(wait);
+		elapsed += wait;
+	}
+	siderealSteps = interrupt.azimuth.currentPosition() + interrupt.altitude.currentPosition();
+
+	const double seconds = duration / 1000000.;
+	printf("%-56s %12.0f %12.0f %12.0f %12.0f\n", name, slewInterrupts / seconds, slewSteps / seconds,
+		siderealInterrupts / seconds, siderealSteps / seconds);
+}
+
+
+// Set once an accuracy report was printed
+static bool accuracyReported = false;
+
+/*
+ * Compares a policy to the textbook formulas in long double over a grid of targets and sidereal times.
+ * The azimuth is only compared below 89 degrees altitude, because it is undefined at the zenith.
+ * "steps off" is the share of the targets above the horizon whose step target differs from the one of the reference.
+ * Differences of one step right at a step boundary can not be avoided by any policy
+ */
+template<typename Policy>
+static void reportAccuracy(Observer& observer) {
+	typedef typename Policy::Real Real;
+
+	char name[64];
+	snprintf(name, sizeof(name), "accuracy/%s", Policy::name());
+	if (!isSelected(name)) {
+		return;
+	}
+	if (!accuracyReported) {
+		printf("\n%-56s %12s %12s %12s %12s %12s\n", "accuracy (arcseconds)", "max az", "max alt", "round trip", "steps off", "max steps");
+		accuracyReported = true;
+	}
+
+	BasicCoordinateEngine<Policy> engine;
+	const typename Policy::StepScale azimuthScale = Policy::stepScale(AZ_STEPS_PER_DEG);
+	const typename Policy::StepScale altitudeScale = Policy::stepScale(ALT_STEPS_PER_DEG);
+
+	const long double toRadians = 3.14159265358979323846264338327950288L / 180.L;
+	const long double latitude = observer.latitude() * toRadians;
+
+	double maxAzimuthError = 0., maxAltitudeError = 0., maxRoundTripError = 0.;
+	unsigned long aboveHorizon = 0, stepsOff = 0;
+	long maxStepsOff = 0;
+
+	for (double lst = 0.; lst < 360.; lst += 37.3) {
+		ObserverTrigonometry trigonometry = observer.trigonometry();
+		trigonometry.version++;
+		engine.update(lst, trigonometry);
+
+		for (double ra = 0.; ra < 360.; ra += 7.3) {
+			for (double dec = -89.; dec <= 89.; dec += 3.7) {
+				const long double hourAngle = (lst - ra) * toRadians;
+				const long double declination = dec * toRadians;
+				const long double up = sinl(latitude) * sinl(declination) + cosl(latitude) * cosl(declination) * cosl(hourAngle);
+				const long double referenceAltitude = asinl(up) / toRadians;
+				long double referenceAzimuth = atan2l(-cosl(declination) * sinl(hourAngle),
+					cosl(latitude) * sinl(declination) - sinl(latitude) * cosl(declination) * cosl(hourAngle)) / toRadians;
+				if (referenceAzimuth < 0.L) {
+					referenceAzimuth += 360.L;
+				}
+
+				const AzAlt<Real> result = engine.toHorizontal(RaDecPosition{ ra, dec });
+
+				double azimuthError = fabs(static_cast<double>(result.azimuth - referenceAzimuth));
+				if (azimuthError > 180.) {
+					azimuthError = 360. - azimuthError;
+				}
+				if (referenceAltitude < 89.L && azimuthError > maxAzimuthError) {
+					maxAzimuthError = azimuthError;
+				}
+				maxAltitudeError = fmax(maxAltitudeError, fabs(static_cast<double>(result.altitude - referenceAltitude)));
+
+				const RaDecPosition back = engine.toEquatorial(result);
+				double raError = fabs(back.rightAscension - ra);
+				if (raError > 180.) {
+					raError = 360. - raError;
+				}
+				// The error on the sky, so that the right ascension near the poles does not dominate
+				const double roundTripError = sqrt(pow(raError * cos(dec * DEG_TO_RAD), 2) + pow(back.declination - dec, 2));
+				if (referenceAltitude < 89.L && roundTripError > maxRoundTripError) {
+					maxRoundTripError = roundTripError;
+				}
+
+				if (referenceAltitude < 0.L) {
+					continue;
+				}
+				aboveHorizon++;
+				const long azimuthSteps = Policy::toSteps(result.azimuth, azimuthScale) - static_cast<long>(floorl(referenceAzimuth * AZ_STEPS_PER_DEG));
+				const long altitudeSteps = Policy::toSteps(result.altitude, altitudeScale) - static_cast<long>(floorl(referenceAltitude * ALT_STEPS_PER_DEG));
+				const long off = labs(azimuthSteps) > labs(altitudeSteps) ? labs(azimuthSteps) : labs(altitudeSteps);
+				if (off != 0) {
+					stepsOff++;
+				}
+				if (off > maxStepsOff) {
+					maxStepsOff = off;
+				}
+			}
+		}
+	}
+
+	printf("%-56s %12.3f %12.3f %12.3f %11.2f%% %12ld\n", name,
+		maxAzimuthError * 3600., maxAltitudeError * 3600., maxRoundTripError * 3600., 100. * stepsOff / aboveHorizon, maxStepsOff);
+}
+
+
+/*
+ * Largest absolute error of the lookup tables in TrigTables.h, compared to libm in double
+ */
+static void reportTrigAccuracy() {
+	if (!isSelected("accuracy/trig")) {
+		return;
+	}
+	accuracyReported = true;
+
+	double sinError = 0., cosError = 0., atan2Error = 0., asinError = 0.;
+	for (int i = -400000; i <= 400000; i++) {
+		const float x = i * static_cast<float>(4. * PI / 400000.);
+		sinError = fmax(sinError, fabs(tableSin(x) - sin(static_cast<double>(x))));
+		cosError = fmax(cosError, fabs(tableCos(x) - cos(static_cast<double>(x))));
+	}
+	for (int i = 0; i < 800000; i++) {
+		const double angle = i * (2. * PI / 800000.) - PI;
+		// Varying lengths, so that the division in tableAtan2() is not always exact
+		const float y = static_cast<float>(sin(angle) * (1. + (i % 7)));
+		const float x = static_cast<float>(cos(angle) * (1. + (i % 7)));
+		double error = fabs(tableAtan2(y, x) - atan2(static_cast<double>(y), static_cast<double>(x)));
+		if (error > PI) {
+			error = 2. * PI - error;
+		}
+		atan2Error = fmax(atan2Error, error);
+	}
+	for (int i = -99990; i <= 99990; i++) {
+		const float x = i / 100000.f;
+		asinError = fmax(asinError, fabs(tableAsin(x) - asin(static_cast<double>(x))));
+	}
+
+	const double toArcseconds = 3600. * RAD_TO_DEG;
+	printf("\n%-56s %12s %12s %12s %12s\n", "accuracy (arcseconds)", "sin", "cos", "atan2", "asin");
+	printf("%-56s %12.3f %12.3f %12.3f %12.3f\n", "accuracy/trig tables", sinError * toArcseconds, cosError * toArcseconds,
+		atan2Error * toArcseconds, asinError * toArcseconds);
+}
+
+
+int main(int argc, char** argv) {
+	if (argc > 1) {
+		benchmarkFilter = argv[1];
+	}
+
+	MountStepper azimuth(MOUNT_STEPPER_PINS(AZ_STEP_PIN, AZ_DIR_PIN));
+	MountStepper altitude(MOUNT_STEPPER_PINS(ALT_STEP_PIN, ALT_DIR_PIN));
+	azimuth.setMaxSpeed(AZ_MAX_SPEED);
+	azimuth.setAcceleration(AZ_MAX_ACCEL);
+	altitude.setMaxSpeed(ALT_MAX_SPEED);
+	altitude.setAcceleration(ALT_MAX_ACCEL);
+
+	FixedObserver observer(ALT, LAT, LNG, INITIAL_YEAR, INITIAL_MONTH, INITIAL_DAY, INITIAL_HOUR, INITIAL_MINUTE, INITIAL_SECOND);
+	observer.initialize();
+
+	Dobson scope(azimuth, altitude, observer);
+	scope.initialize();
+	initCommunication(scope);
+
+	// The mounts ignore moves during the first seconds after startup
+	hostAdvanceClock(10000000UL);
+	scope.setHomed(true);
+
+	printf("AZ_STEPS_PER_REV=%.1f ALT_STEPS_PER_REV=%.1f\n\n", (double)AZ_STEPS_PER_REV, (double)ALT_STEPS_PER_REV);
+	printf("%-56s %12s %12s %12s %12s\n", "benchmark", "ns/call", "allocs/call", "tx B/call", "calls");
+
+	/*
+	 * Coordinate conversion
+	 */
+	runBenchmark("location/get_local_sidereal_time", [&](unsigned long) {
+		sink = get_local_sidereal_time(observer.longitude());
+	});
+
+	runBenchmark("Observer/localSiderealTime", [&](unsigned long) {
+		sink = observer.localSiderealTime();
+	});
+
+	runBenchmark("Dobson/raDecToAltAz", [&](unsigned long i) {
+		const AzAlt<double> result = scope.raDecToAltAz(targets[i % targetCount]);
+		sink = result.azimuth + result.altitude;
+	});
+
+	runBenchmark("Dobson/azAltToRaDec", [&](unsigned long i) {
+		const RaDecPosition& target = targets[i % targetCount];
+		const RaDecPosition result = scope.azAltToRaDec({ target.rightAscension, target.declination * 0.5 + 45. });
+		sink = result.rightAscension + result.declination;
+	});
+
+	/*
+	 * Trig functions of libm and the lookup tables (TrigTables.h)
+	 */
+	runBenchmark("trig/sinf", [&](unsigned long i) {
+		sink = sinf(i * 0.001f);
+	});
+
+	runBenchmark("trig/tableSin", [&](unsigned long i) {
+		sink = tableSin(i * 0.001f);
+	});
+
+	runBenchmark("trig/atan2f", [&](unsigned long i) {
+		sink = atan2f(static_cast<float>(i & 1023) - 512.f, 300.f);
+	});
+
+	runBenchmark("trig/tableAtan2", [&](unsigned long i) {
+		sink = tableAtan2(static_cast<float>(i & 1023) - 512.f, 300.f);
+	});
+
+	/*
+	 * Rotation matrix engine, once per numeric policy
+	 */
+	benchmarkCoordinateEngine<Float32Policy>(observer);
+	benchmarkCoordinateEngine<LookupTablePolicy>(observer);
+	benchmarkCoordinateEngine<Float64Policy>(observer);
+	benchmarkCoordinateEngine<FixedPointPolicy>(observer);
+
+	static RaDecPosition catalog[catalogSize];
+	static AzAlt<double> catalogHorizontal[catalogSize];
+	fillCatalog(catalog);
+
+	runBenchmark("Dobson/raDecToAltAz[256] (scalar)", [&](unsigned long) {
+		for (unsigned int i = 0; i < catalogSize; i++) {
+			catalogHorizontal[i] = scope.raDecToAltAz(catalog[i]);
+		}
+		sink = catalogHorizontal[0].altitude;
+	});
+
+	runBenchmark("Dobson/calculateMotorTargets", [&](unsigned long i) {
+		scope.setTarget(targets[i % targetCount]);
+		scope.calculateMotorTargets();
+	});
+
+	// This is what loop() does on every motor update (see Mount::isUpdateDue()), including the debug output of move()
+	// The stepper interrupt then starts the queued move, which also keeps the motion queue from filling up
+	runBenchmark("Dobson/calculateMotorTargets+move", [&](unsigned long i) {
+		scope.setTarget(targets[i % targetCount]);
+		scope.calculateMotorTargets();
+		scope.move();
+		scope.startDueSegments(0);
+	});
+
+	// What the stepper interrupt and the main loop each add to share the positions of the steppers (see SeqLock.h)
+	runBenchmark("Mount/publishSteppers+stepperSnapshot", [&](unsigned long i) {
+		scope.publishSteppers(static_cast<long>(i), -static_cast<long>(i), i);
+		sink = scope.stepperSnapshot().position.azimuth;
+	});
+
+	/*
+	 * Stepper interrupt
+	 */
+	benchmarkStepInterrupt<AccelStepperInterrupt>();
+	benchmarkStepInterrupt<StepGeneratorInterrupt>();
+
+	// Trajectory tracking: the interrupt evaluates one polynomial per axis and tick (see Trajectory.h)
+	Trajectory trajectory;
+	double trajectoryTimes[TRAJECTORY_SAMPLES];
+	const double trajectoryPositions[TRAJECTORY_SAMPLES] = { 28724.3, 28726.1, 28729.8, 28731.2 };
+	Trajectory::sampleTimes(TRAJECTORY_WINDOW_MS / 1000., trajectoryTimes);
+	runBenchmark("Trajectory/fit+start", [&](unsigned long) {
+		trajectory.fit(trajectoryTimes, trajectoryPositions);
+		trajectory.start(0.001, STEPPER_INTERRUPT_FREQ / 1000000., TRAJECTORY_WINDOW_MS / 1000.);
+	});
+
+	runBenchmark("Trajectory/nextTick", [&](unsigned long) {
+		sink = trajectory.nextTick();
+	});
+
+	// Slews: planning the phases before the slew starts, and turning one phase into the trajectories of a segment (see SlewPlanner.h)
+	SlewPlanner slew;
+	runBenchmark("SlewPlanner/plan", [&](unsigned long i) {
+		sink = slew.plan({ 0, 0 }, { 20000 + (long)(i & 1023), -10000 });
+	});
+
+	Trajectory slewAzimuth;
+	Trajectory slewAltitude;
+	runBenchmark("SlewPlanner/phaseTrajectories", [&](unsigned long i) {
+		slew.phaseTrajectories(i % slew.phases(), STEPPER_INTERRUPT_FREQ / 1000000., slewAzimuth, slewAltitude);
+	});
+
+	// Scheduling: picking and running the most urgent of five empty tasks, all of them due (see Scheduler.h)
+	SchedulerTask benchTasks[] = {
+		{ "motor", &benchTask, 0, 10000, 4, 0, 0, 0, 0, 0, 0 },
+		{ "controls", &benchTask, 0, 20000, 3, 0, 0, 0, 0, 0, 0 },
+		{ "observer", &benchTask, 0, 5000, 1, 0, 0, 0, 0, 0, 0 },
+		{ "serial", &benchTask, 0, 10000, 1, 0, 0, 0, 0, 0, 0 },
+		{ "display", &benchTask, 0, 20000, 1, 0, 0, 0, 0, 0, 0 },
+	};
+	Scheduler scheduler(benchTasks, sizeof(benchTasks) / sizeof(benchTasks[0]));
+	scheduler.start();
+	runBenchmark("Scheduler/runNext", [&](unsigned long) {
+		sink = scheduler.runNext();
+	});
+
+	// What every stepper interrupt adds for the histograms of :PERF# (see Profiler.h)
+	runBenchmark("Profiler/recordTick", [&](unsigned long i) {
+		Profiler::recordTick(i * 100, 100, i & 63);
+	});
+
+	// Building one frame of the :TLM# stream, without sending it (see Telemetry.h)
+	runBenchmark("Telemetry/encode", [&](unsigned long i) {
+		TelemetryFrame frame;
+		frame.timestamp = i;
+		const RaDecPosition target = scope.getTarget();
+		frame.targetRa = target.rightAscension;
+		frame.targetDec = target.declination;
+		frame.commanded = scope.getSteppersTarget();
+		frame.actual = scope.stepperSnapshot().position;
+		frame.mode = scope.getMode();
+		frame.loopMicros = i & 1023;
+		frame.tickMicros = i & 63;
+		uint8_t data[Telemetry::FRAME_SIZE];
+		Telemetry::encode(frame, data);
+		sink = data[Telemetry::FRAME_SIZE - 1];
+	});
+
+	/*
+	 * Serial communication
+	 * These receive and run whole commands. One handleSerialCommunication() call reads everything that arrived
+	 */
+	runBenchmark("handleSerialCommunication/idle", [&](unsigned long) {
+		handleSerialCommunication(scope, observer);
+	});
+
+	runBenchmark("parseCommands/:GR#", [&](unsigned long) {
+		runSerialCommand(scope, observer, ":GR#");
+	});
+
+	runBenchmark("parseCommands/:GD#", [&](unsigned long) {
+		runSerialCommand(scope, observer, ":GD#");
+	});
+
+	runBenchmark("parseCommands/:Sr,HH:MM:SS#", [&](unsigned long) {
+		runSerialCommand(scope, observer, ":Sr,16:41:42#");
+	});
+
+	runBenchmark("parseCommands/:Sd,+DD:MM:SS#", [&](unsigned long) {
+		runSerialCommand(scope, observer, ":Sd,+36:27:36#");
+	});
+
+	// A new target from Stellarium arrives as a burst of both coordinates
+	runBenchmark("parseCommands/:Sr..#:Sd..#", [&](unsigned long) {
+		runSerialCommand(scope, observer, ":Sr,16:41:42#:Sd,+36:27:36#");
+	});
+
+	Profiler::setScheduler(scheduler);
+	runBenchmark("parseCommands/:PERF#", [&](unsigned long) {
+		runSerialCommand(scope, observer, ":PERF#");
+	});
+
+	// Buffered output as after setup(): A debug line and a reply are buffered, then sent by the serial task
+	SerialOutput::setBuffered(true);
+	runBenchmark("SerialOutput/debug line + :GR# reply", [&](unsigned long) {
+		SerialDebug.println("Moving telescope to new target");
+		SerialReplies.print("16:41:34#");
+		SerialOutput::flush();
+	});
+	SerialOutput::setBuffered(false);
+
+	runBenchmark("handleDisplayCommunication/idle", [&](unsigned long) {
+		handleDisplayCommunication(scope, observer);
+	});
+
+	/*
+	 * Accuracy of the numeric policies
+	 */
+	reportAccuracy<Float32Policy>(observer);
+	reportAccuracy<LookupTablePolicy>(observer);
+	reportAccuracy<Float64Policy>(observer);
+	reportAccuracy<FixedPointPolicy>(observer);
+	reportTrigAccuracy();
+	if (accuracyReported) {
+		printf("One step is %.2f\" in azimuth and %.2f\" in altitude. The configured policy is %s\n",
+			3600. / AZ_STEPS_PER_DEG, 3600. / ALT_STEPS_PER_DEG, CoordinatePolicy::name());
+	}
+
+	/*
+	 * Stepper interrupts per second
+	 */
+	reportStepInterruptRate<AccelStepperInterrupt>();
+	reportStepInterruptRate<StepGeneratorInterrupt>();
+
+	return 0;
+}
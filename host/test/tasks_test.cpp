@@ -0,0 +1,177 @@
+/*
+ * tasks_test.cpp
+ *
+ * Runs the tasks of the firmware and their table (see Tasks.h) with the scheduler, the way loop() does, while Stellarium polls
+ * the position and the :TLM# telemetry stream runs. Checks that every task gets to run in time, that the frames come out
+ * at their rate and decode (see Telemetry.h), that the replies to the commands arrive in between, and that :TLM0# stops the stream.
+ * This defines the mount and the observer of the sketch, without its stepper interrupt.
+ *
+ * The clock is stopped (see hostStopClock()), and every loop() iteration takes LOOP_MICROS of it. So the results are the same
+ * however fast or busy the host is.
+ * Built by the host build and run by ctest (see CMakeLists.txt). Exits with 1 if a check failed
+ */
+#include <stdio.h>
+#include <string>
+
+#include <Arduino.h>
+#include <AccelStepper.h>
+
+#include "config.h"
+#include "conversion.h"
+#include "display_unit.h"
+#include "Profiler.h"
+#include "SerialOutput.h"
+#include "StepGenerator.h"
+#include "Tasks.h"
+#include "Telemetry.h"
+
+
+MountStepper azimuth(MOUNT_STEPPER_PINS(AZ_STEP_PIN, AZ_DIR_PIN));
+MountStepper altitude(MOUNT_STEPPER_PINS(ALT_STEP_PIN, ALT_DIR_PIN));
+FixedObserver observer(ALT, LAT, LNG, INITIAL_YEAR, INITIAL_MONTH, INITIAL_DAY, INITIAL_HOUR, INITIAL_MINUTE, INITIAL_SECOND);
+Dobson scope(azimuth, altitude, observer);
+
+// Time each loop() iteration takes on the simulated clock
+static const unsigned long LOOP_MICROS = 100;
+
+static unsigned int failures = 0;
+
+static void check(const bool passed, const char* description) {
+	printf("%s %s\n", passed ? "ok  " : "FAIL", description);
+	if (!passed) {
+		failures++;
+	}
+}
+
+
+// Runs loop() for durationMicros. Every pollMicros, Stellarium asks for the position
+static void runLoop(const unsigned long durationMicros, const unsigned long pollMicros, unsigned int& polls) {
+	for (unsigned long elapsed = 0; elapsed < durationMicros; elapsed += LOOP_MICROS) {
+		if (elapsed % pollMicros == 0) {
+			Serial.hostInject(":GR#:GD#");
+			polls++;
+		}
+		const unsigned long loopStart = micros();
+		scheduler.runNext();
+		hostAdvanceClock(LOOP_MICROS);
+		Profiler::recordLoop(micros() - loopStart);
+	}
+}
+
+
+// Splits the output of the port into the frames and the text between them, like host/tools/telemetry_csv.cpp
+static void splitOutput(const std::string& output, unsigned long& frames, unsigned long& longestIntervalMicros, std::string& text) {
+	frames = 0;
+	longestIntervalMicros = 0;
+	unsigned long previousTimestamp = 0;
+
+	size_t i = 0;
+	while (i < output.size()) {
+		TelemetryFrame frame;
+		if (output.size() - i >= Telemetry::FRAME_SIZE && Telemetry::decode(reinterpret_cast<const uint8_t*>(output.data() + i), frame)) {
+			if (frames > 0 && frame.timestamp - previousTimestamp > longestIntervalMicros) {
+				longestIntervalMicros = frame.timestamp - previousTimestamp;
+			}
+			previousTimestamp = frame.timestamp;
+			frames++;
+			i += Telemetry::FRAME_SIZE;
+		}
+		else {
+			text += output[i++];
+		}
+	}
+}
+
+
+static unsigned long countReplies(const std::string& text) {
+	unsigned long replies = 0;
+	for (size_t i = 0; i < text.size(); i++) {
+		replies += text[i] == '#';
+	}
+	return replies;
+}
+
+
+int main() {
+	hostStopClock();
+
+	azimuth.setMaxSpeed(AZ_MAX_SPEED);
+	azimuth.setAcceleration(AZ_MAX_ACCEL);
+	altitude.setMaxSpeed(ALT_MAX_SPEED);
+	altitude.setAcceleration(ALT_MAX_ACCEL);
+	observer.initialize();
+	scope.initialize();
+	initCommunication(scope);
+	#ifdef SERIAL_DISPLAY_ENABLED
+		initDisplayCommunication(scope);
+	#endif
+
+	// The mounts ignore moves during the first seconds after startup
+	hostAdvanceClock(10000000UL);
+	scope.setHomed(true);
+
+	// From here on as in setup()
+	SerialOutput::setBuffered(true);
+	Profiler::setScheduler(scheduler);
+	scheduler.start();
+	Serial.hostTakeOutput();
+	Serial.hostCapture(true);
+
+	// One second of the stream at 50 Hz, while Stellarium asks for the position ten times per second
+	const unsigned long rate = 50;
+	const unsigned long intervalMicros = 1000000UL / rate;
+	Serial.hostInject(":TLM50#");
+	unsigned int polls = 0;
+	runLoop(1000000UL, 100000UL, polls);
+
+	unsigned long frames;
+	unsigned long longestInterval;
+	std::string text;
+	splitOutput(Serial.hostTakeOutput(), frames, longestInterval, text);
+	printf("%lu frames, %lu dropped, longest interval %luus, %lu replies to %u polls\n",
+		frames, Telemetry::droppedFrames(), longestInterval, countReplies(text), polls);
+
+	check(frames == rate, "the stream sends 50 frames per second");
+	check(Telemetry::droppedFrames() == 0, "no frame is dropped");
+	// A frame can be late by the time until the telemetry task gets its next turn. The next one keeps to the rate again
+	check(longestInterval <= intervalMicros + 1000UL, "no frame is late by more than 1ms");
+	check(text.find("Telemetry at 50 Hz") != std::string::npos, ":TLM50# is answered");
+	check(countReplies(text) == 2 * polls, ":GR# and :GD# are answered while the stream runs");
+
+	for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+		const SchedulerTask& task = scheduler.task(i);
+		// Periodic tasks run once per period. The ones with period 0 at least once per deadline
+		const unsigned long expectedRuns = 1000000UL / (task.periodMicros > 0 ? task.periodMicros : task.deadlineMicros);
+		char description[80];
+		snprintf(description, sizeof(description), "task %s runs in time (%lu runs, %lu overruns)", task.name, task.runs, task.overruns);
+		check(task.runs >= expectedRuns && task.overruns == 0, description);
+	}
+
+	// The tasks with period 0 take turns, so each of them runs about as often as the one that runs most
+	unsigned long mostPolls = 0;
+	for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+		const SchedulerTask& task = scheduler.task(i);
+		if (task.periodMicros == 0 && task.runs > mostPolls) {
+			mostPolls = task.runs;
+		}
+	}
+	for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+		const SchedulerTask& task = scheduler.task(i);
+		if (task.periodMicros == 0) {
+			char description[80];
+			snprintf(description, sizeof(description), "task %s gets its turn (%lu of %lu runs)", task.name, task.runs, mostPolls);
+			check(task.runs * 100 >= mostPolls * 99, description);
+		}
+	}
+
+	// After :TLM0#, only replies come out
+	Serial.hostInject(":TLM0#");
+	runLoop(200000UL, 100000UL, polls);
+	text.clear();
+	splitOutput(Serial.hostTakeOutput(), frames, longestInterval, text);
+	check(frames <= 1, ":TLM0# stops the stream");
+	check(text.find("Telemetry stopped") != std::string::npos, ":TLM0# is answered");
+
+	printf("%u checks failed\n", failures);
+	return failures == 0 ? 0 : 1;
+}
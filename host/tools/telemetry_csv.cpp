@@ -0,0 +1,87 @@
+/*
+ * telemetry_csv.cpp
+ *
+ * Turns a recording of the telemetry stream (see Telemetry.h) into CSV, one row per frame.
+ * Everything between the frames, like replies to commands, is skipped. So is every frame with a wrong checksum.
+ * The time column counts the seconds since the first frame and continues where micros() of the board wraps around.
+ * The tracking error columns are the actual minus the commanded stepper position.
+ *
+ * Usage: dobson_telemetry_csv [recording] > night.csv
+ * Reads stdin if no recording is given, e.g. while recording the port: stty -F /dev/ttyACM0 56000 raw && dobson_telemetry_csv /dev/ttyACM0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Telemetry.h"
+
+
+int main(int argc, char** argv) {
+	FILE* in = stdin;
+	if (argc > 1) {
+		in = fopen(argv[1], "rb");
+		if (in == nullptr) {
+			fprintf(stderr, "Can not open %s\n", argv[1]);
+			return 1;
+		}
+	}
+
+	printf("time_s,timestamp_us,target_ra_deg,target_dec_deg,commanded_az,commanded_alt,actual_az,actual_alt,error_az,error_alt,mode,loop_max_us,isr_max_us\n");
+
+	// The bytes read so far that can still be the beginning of a frame
+	uint8_t data[Telemetry::FRAME_SIZE];
+	unsigned int size = 0;
+
+	unsigned long frames = 0;
+	unsigned long skippedBytes = 0;
+	uint32_t previousTimestamp = 0;
+	double seconds = 0;
+
+	// Drops the first count bytes of data, and then all bytes up to the next pair of sync bytes
+	auto skip = [&](unsigned int count) {
+		do {
+			memmove(data, data + count, size - count);
+			skippedBytes += count;
+			size -= count;
+			count = 1;
+		} while (size > 0 && (data[0] != Telemetry::SYNC_1 || (size > 1 && data[1] != Telemetry::SYNC_2)));
+	};
+
+	int c;
+	while ((c = fgetc(in)) != EOF) {
+		data[size++] = static_cast<uint8_t>(c);
+		skip(0);
+		if (size < Telemetry::FRAME_SIZE) {
+			continue;
+		}
+
+		TelemetryFrame frame;
+		if (!Telemetry::decode(data, frame)) {
+			// Starts with the sync bytes, but is not a frame. The next one may start within it
+			skip(1);
+			continue;
+		}
+		size = 0;
+
+		const uint32_t timestamp = static_cast<uint32_t>(frame.timestamp);
+		if (frames > 0) {
+			// uint32_t arithmetic continues across the wrap around of micros()
+			seconds += static_cast<uint32_t>(timestamp - previousTimestamp) / 1e6;
+		}
+		previousTimestamp = timestamp;
+		frames++;
+
+		printf("%.6f,%lu,%.6f,%.6f,%ld,%ld,%ld,%ld,%ld,%ld,%u,%u,%u\n",
+			seconds, static_cast<unsigned long>(timestamp), frame.targetRa, frame.targetDec,
+			frame.commanded.azimuth, frame.commanded.altitude, frame.actual.azimuth, frame.actual.altitude,
+			frame.actual.azimuth - frame.commanded.azimuth, frame.actual.altitude - frame.commanded.altitude,
+			frame.mode, frame.loopMicros, frame.tickMicros);
+	}
+
+	fprintf(stderr, "%lu frames, %lu bytes skipped\n", frames, skippedBytes);
+	if (in != stdin) {
+		fclose(in);
+	}
+	return 0;
+}
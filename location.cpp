@@ -80,6 +80,8 @@ double get_local_sidereal_time2(const double degrees_longitude) {
 
 
 // Uses the algorithm from http://www2.arnes.si/~gljsentvid10/sidereal.htm
+// This only has a resolution of one second and reads the calendar fields from TimeLib, which is slow.
+// It is only used to anchor the SiderealClock when the time is set. Use Observer::localSiderealTime() everywhere else
 double get_local_sidereal_time(const double degrees_longitude) {
 	const double d1 = 367. * year();
 	const double d2 = 275. * month() / 9.;
@@ -7,4 +7,8 @@
 // This Macro converts a character to an integer
 #define char_to_int(x) (x - '0')
 // This Macro converts two characters to an integer. Example: ctoi10('2', '3') => 23
-#define multi_char_to_int(x, y) ((x - '0') * 10 + (y - '0'))
\ No newline at end of file
+#define multi_char_to_int(x, y) ((x - '0') * 10 + (y - '0'))
+
+// Keeps the compiler from moving memory accesses across this point. Used between the main loop and interrupts
+// (see RingBuffer.h and SeqLock.h). The boards have a single core, so the CPU itself never reorders them for an interrupt
+#define COMPILER_BARRIER() __asm__ __volatile__("" ::: "memory")
\ No newline at end of file